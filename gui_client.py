@@ -1,8 +1,9 @@
 # gui_client.py — LIST + GET/HEAD with optional TYPE header, text or image preview
+# The file list follows server-side changes live via WATCH (falls back to manual Refresh).
 # Requires: Python 3.7+
 # Optional: Pillow for image preview →  python3 -m pip install pillow
 
-import socket, io, sys, tempfile, os, subprocess, tkinter as tk
+import socket, io, sys, tempfile, os, subprocess, threading, tkinter as tk
 from tkinter import ttk, messagebox, filedialog
 
 # Optional image support
@@ -57,6 +58,22 @@ def list_files(host: str, port: str):
             entries.append((name, mime, size))
         return entries
 
+def watch_files(host: str, port: str):
+    """
+    Opens a WATCH subscription. Returns (socket, line_reader) once the server
+    has acknowledged with "WATCHING"; raises if the server can't watch.
+    Events: "ADD|MOD <name>\t<size>", "DEL <name>", "RESYNC".
+    """
+    s = socket.create_connection((host, int(port)), timeout=5)
+    s.sendall(b"WATCH\n")
+    head = _recv_line(s)
+    if not head.startswith(b"WATCHING"):
+        s.close()
+        raise RuntimeError(f"WATCH refused: {head!r}")
+    _recv_line(s)  # blank line
+    s.settimeout(None)  # events may be minutes apart
+    return s, s.makefile("rb")
+
 def fetch_file(host: str, port: str, name: str, head_only=False):
     """
     Returns: (data_bytes_or_b"", mime_str_or"", size_int)
@@ -120,6 +137,8 @@ class App(tk.Tk):
         self.current_data = b""
         self.current_mime = ""
         self.tk_img = None  # keep reference for Tk
+        self.entries = {}   # name -> (mime, size), mirrors the listbox
+        self.watch_sock = None
 
         # layout
         root = ttk.Frame(self, padding=8)
@@ -203,18 +222,77 @@ class App(tk.Tk):
             entries = list_files(host, port)
         except Exception as e:
             messagebox.showerror("Error", str(e)); return
+        self.entries = {name: (mime, size) for name, mime, size in entries}
+        self._render_list()
+        # clear preview
+        self.current_name = None
+        self.current_data = b""
+        self.current_mime = ""
+        self._show_text("")
+        self._start_watch(host, port)
+
+    def _render_list(self):
+        sel = self.files.curselection()
+        selected = self._extract_name_from_list_label(self.files.get(sel[0])) if sel else None
         self.files.delete(0, "end")
-        for name, mime, size in entries:
+        for name in sorted(self.entries):
+            mime, size = self.entries[name]
             if mime:
                 label = f"{name}    [{mime}] ({size} bytes)"
             else:
                 label = f"{name}    ({size} bytes)"
             self.files.insert("end", label)
-        # clear preview
-        self.current_name = None
-        self.current_data = b""
-        self.current_mime = ""
-        self._show_text("")
+            if name == selected:
+                self.files.selection_set("end")
+
+    # ---- live updates (WATCH) ----
+
+    def _start_watch(self, host, port):
+        self._stop_watch()
+        try:
+            sock, reader = watch_files(host, port)
+        except Exception:
+            return  # older/non-Linux server: Refresh stays manual
+        self.watch_sock = sock
+        threading.Thread(target=self._watch_loop, args=(sock, reader), daemon=True).start()
+
+    def _stop_watch(self):
+        if self.watch_sock is not None:
+            try:
+                self.watch_sock.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            self.watch_sock.close()
+            self.watch_sock = None
+
+    def _watch_loop(self, sock, reader):
+        # runs on a worker thread; Tk is only touched via after()
+        try:
+            for raw in reader:
+                line = raw.decode("utf-8", "replace").rstrip("\r\n")
+                self.after(0, self._apply_watch_event, sock, line)
+        except (OSError, ValueError):
+            pass
+
+    def _apply_watch_event(self, sock, line):
+        if sock is not self.watch_sock:
+            return  # stale event from a subscription we already replaced
+        kind, _, rest = line.partition(" ")
+        if kind in ("ADD", "MOD"):
+            name, _, size = rest.partition("\t")
+            mime = self.entries.get(name, ("", ""))[0]
+            self.entries[name] = (mime, size)
+        elif kind == "DEL":
+            self.entries.pop(rest, None)
+        elif kind == "RESYNC":
+            host, port = self.host.get().strip(), self.port.get().strip()
+            try:
+                self.entries = {n: (m, sz) for n, m, sz in list_files(host, port)}
+            except Exception:
+                return
+        else:
+            return
+        self._render_list()
 
     def _extract_name_from_list_label(self, label: str) -> str:
         # label formats: "name    (size bytes)" OR "name    [mime] (size bytes)"
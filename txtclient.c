@@ -2,18 +2,39 @@
 // Usage:
 //   txtclient <host> <port>           # prints file to stdout
 //   txtclient --head <host> <port>    # prints only SIZE header
+//   txtclient -f <host> <port> [off]  # follow: print from <off> (default -4096 =
+//                                     # last 4 KiB), then stream appended bytes
+//   txtclient -m <host> <port> [ifaddr]
+//                                     # multicast receive: join the group the server
+//                                     # announces, repair gaps over TCP, print file
+//                                     # (assembled in place when stdout is a regular
+//                                     # file, else in a temp file; never in memory)
 
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE    // struct ip_mreq (glibc)
+#define _DARWIN_C_SOURCE   // struct ip_mreq (macOS)
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+#define MCAST_MAGIC   0x54584d31u   // "TXM1"
+#define MCAST_HDR     16
+#define MCAST_END     UINT64_MAX
+#define MCAST_IDLE_MS 1000          // silence that ends a round when END was lost
+#define REPAIR_BATCH  64            // REPAIR lines in flight per round trip
+
 static int send_all(int fd, const void *buf, size_t len) {
     const char *p = (const char *)buf;
     while (len) {
@@ -38,14 +59,254 @@ static ssize_t recv_line(int fd, char *buf, size_t maxlen) {
     return (ssize_t)i;
 }
 
+static int recv_exact(int fd, char *buf, size_t len) {
+    while (len) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n == 0) return -1;
+        if (n < 0) { if (errno == EINTR) continue; return -1; }
+        buf += n; len -= (size_t)n;
+    }
+    return 0;
+}
+
+// TAIL mode: print the server's DATA frames as they arrive; TRUNC/ROTATE are
+// reported on stderr so stdout stays a clean copy of the file's bytes.
+static int follow(int fd, const char *offset) {
+    char cmd[64];
+    int cn = snprintf(cmd, sizeof(cmd), "TAIL %s\n", offset);
+    if (send_all(fd, cmd, (size_t)cn) < 0) { perror("send"); return 1; }
+
+    char line[128];
+    if (recv_line(fd, line, sizeof(line)) <= 0) { fprintf(stderr, "protocol error (no FROM)\n"); return 1; }
+    long long from = -1;
+    if (sscanf(line, "FROM %lld", &from) != 1) { fprintf(stderr, "%s", line); return 1; }
+    if (recv_line(fd, line, sizeof(line)) <= 0 || strcmp(line, "\n") != 0) {
+        fprintf(stderr, "protocol error (no blank line)\n"); return 1;
+    }
+
+    char buf[65536];
+    for (;;) {
+        if (recv_line(fd, line, sizeof(line)) <= 0) { fprintf(stderr, "connection closed\n"); return 1; }
+        long long n = 0;
+        if (sscanf(line, "DATA %lld", &n) == 1 && n >= 0) {
+            while (n > 0) {
+                size_t chunk = (n > (long long)sizeof(buf)) ? sizeof(buf) : (size_t)n;
+                if (recv_exact(fd, buf, chunk) < 0) { fprintf(stderr, "connection closed\n"); return 1; }
+                fwrite(buf, 1, chunk, stdout);
+                n -= (long long)chunk;
+            }
+            fflush(stdout);
+        } else if (sscanf(line, "TRUNC %lld", &n) == 1) {
+            fprintf(stderr, "txtclient: file truncated to %lld bytes\n", n);
+        } else if (strcmp(line, "ROTATE\n") == 0) {
+            fprintf(stderr, "txtclient: file replaced, following new file\n");
+        } else {
+            fprintf(stderr, "%s", line);
+            return 1;
+        }
+    }
+}
+
+// ---- MCAST mode ----
+
+static long long mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static int pwrite_all(int fd, const void *buf, size_t len, off_t off) {
+    const char *p = (const char *)buf;
+    while (len) {
+        ssize_t n = pwrite(fd, p, len, off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n; off += n; len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Reads the server's "DATA <n>" answer for one REPAIR into out at off.
+static int recv_repair(int fd, int out, long long off, long long len) {
+    char line[64], buf[65536];
+    long long n = -1;
+    if (recv_line(fd, line, sizeof(line)) <= 0 || sscanf(line, "DATA %lld", &n) != 1 || n != len) {
+        fprintf(stderr, "repair failed: %s", line);
+        return -1;
+    }
+    while (len > 0) {
+        size_t want = (len > (long long)sizeof(buf)) ? sizeof(buf) : (size_t)len;
+        if (recv_exact(fd, buf, want) < 0 || pwrite_all(out, buf, want, (off_t)off) < 0) return -1;
+        off += (long long)want; len -= (long long)want;
+    }
+    return 0;
+}
+
+// Where the file is assembled: stdout itself when it is a regular file we can
+// pwrite() into from offset 0, else an unlinked temp file copied out at the end.
+static int mcast_output(long long size, FILE **tmp) {
+    struct stat st;
+    int fl = fcntl(STDOUT_FILENO, F_GETFL);
+    *tmp = NULL;
+    if (fstat(STDOUT_FILENO, &st) == 0 && S_ISREG(st.st_mode) && fl >= 0 && !(fl & O_APPEND) &&
+        lseek(STDOUT_FILENO, 0, SEEK_CUR) == 0 && ftruncate(STDOUT_FILENO, (off_t)size) == 0)
+        return STDOUT_FILENO;
+    *tmp = tmpfile();
+    return *tmp ? fileno(*tmp) : -1;
+}
+
+// Join the announced group, collect datagrams until the round ends, then fetch
+// whatever is missing over the TCP connection and write the file to stdout.
+static int mcast_receive(int fd, const char *ifaddr) {
+    if (send_all(fd, "MCAST\n", 6) < 0) { perror("send"); return 1; }
+    char line[256], group[64];
+    unsigned port, session, chunk;
+    long long size, start_ms;
+    if (recv_line(fd, line, sizeof(line)) <= 0) { fprintf(stderr, "protocol error (no MCAST)\n"); return 1; }
+    if (sscanf(line, "MCAST %63s %u %lld %u %u %lld", group, &port, &size, &session, &chunk, &start_ms) != 6 ||
+        size < 0 || chunk == 0) {
+        fprintf(stderr, "%s", line);
+        return 1;
+    }
+    if (recv_line(fd, line, sizeof(line)) <= 0 || strcmp(line, "\n") != 0) {
+        fprintf(stderr, "protocol error (no blank line)\n"); return 1;
+    }
+
+    int us = socket(AF_INET, SOCK_DGRAM, 0);
+    if (us < 0) { perror("socket"); return 1; }
+    int yes = 1, rcvbuf = 8 << 20;
+    setsockopt(us, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));   // several receivers per host
+    setsockopt(us, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    sa.sin_addr.s_addr = htonl(INADDR_ANY);
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1 ||
+        (ifaddr && inet_pton(AF_INET, ifaddr, &mreq.imr_interface) != 1) ||
+        bind(us, (struct sockaddr *)&sa, sizeof(sa)) < 0 ||
+        setsockopt(us, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        perror("multicast join");
+        close(us);
+        return 1;
+    }
+
+    size_t nchunks = (size_t)((size + chunk - 1) / chunk);
+    unsigned char *have = calloc(nchunks ? nchunks : 1, 1);
+    if (!have) { fprintf(stderr, "oom\n"); close(us); return 1; }
+    FILE *tmp;
+    int out = mcast_output(size, &tmp);
+    if (out < 0) { perror("tmpfile"); free(have); close(us); return 1; }
+
+    size_t got_chunks = 0;
+    long long via_mcast = 0, deadline = mono_ms() + start_ms + 3 * MCAST_IDLE_MS;
+    unsigned char pkt[65536];
+    while (got_chunks < nchunks) {
+        long long wait = deadline - mono_ms();
+        if (wait <= 0) break;
+        struct pollfd pfd[2] = { { us, POLLIN, 0 }, { fd, POLLIN, 0 } };
+        int pr = poll(pfd, 2, (int)wait);
+        if (pr < 0) { if (errno == EINTR) continue; break; }
+        if (pfd[1].revents) {
+            fprintf(stderr, "server closed the connection\n");
+            if (tmp) fclose(tmp);
+            free(have); close(us); return 1;
+        }
+        if (!(pfd[0].revents & POLLIN)) continue;
+
+        ssize_t n = recv(us, pkt, sizeof(pkt), 0);
+        if (n < MCAST_HDR) continue;
+        uint32_t magic, sess;
+        memcpy(&magic, pkt, 4);
+        memcpy(&sess, pkt + 4, 4);
+        if (ntohl(magic) != MCAST_MAGIC || ntohl(sess) != session) continue;   // other files/rounds
+        deadline = mono_ms() + MCAST_IDLE_MS;
+        uint64_t off = get_u64(pkt + 8);
+        if (off == MCAST_END) break;
+        size_t len = (size_t)n - MCAST_HDR;
+        if (off % chunk != 0 || off + len > (uint64_t)size) continue;
+        size_t idx = (size_t)(off / chunk);
+        if (have[idx]) continue;
+        if (pwrite_all(out, pkt + MCAST_HDR, len, (off_t)off) < 0) { perror("write"); break; }
+        have[idx] = 1;
+        got_chunks++;
+        via_mcast += (long long)len;
+    }
+    close(us);
+
+    // Missing chunks, merged into ranges; REPAIR_BATCH requests per round trip
+    long long repaired = 0;
+    int rc = 0;
+    size_t i = 0;
+    while (rc == 0 && i < nchunks) {
+        long long roff[REPAIR_BATCH], rlen[REPAIR_BATCH];
+        int nr = 0;
+        char req[REPAIR_BATCH * 48];
+        size_t rn = 0;
+        for (; i < nchunks && nr < REPAIR_BATCH; i++) {
+            if (have[i]) continue;
+            size_t j = i;
+            while (j < nchunks && !have[j]) j++;
+            roff[nr] = (long long)i * chunk;
+            rlen[nr] = ((long long)j * chunk > size ? size : (long long)j * chunk) - roff[nr];
+            rn += (size_t)snprintf(req + rn, sizeof(req) - rn, "REPAIR %lld %lld\n", roff[nr], rlen[nr]);
+            nr++;
+            i = j;
+        }
+        if (nr == 0) break;
+        if (send_all(fd, req, rn) < 0) { rc = 1; break; }
+        for (int k = 0; k < nr && rc == 0; k++) {
+            if (recv_repair(fd, out, roff[k], rlen[k]) < 0) rc = 1;
+            repaired += rlen[k];
+        }
+    }
+    send_all(fd, "DONE\n", 5);
+
+    if (rc == 0 && tmp) {   // stream the assembled temp file out
+        char buf[65536];
+        for (long long off = 0; off < size && rc == 0; ) {
+            ssize_t n = pread(out, buf, sizeof(buf), (off_t)off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0 || fwrite(buf, 1, (size_t)n, stdout) != (size_t)n) { perror("write"); rc = 1; break; }
+            off += n;
+        }
+    }
+    if (rc == 0)
+        fprintf(stderr, "txtclient: %lld bytes, %lld via multicast, %lld repaired over TCP\n", size, via_mcast, repaired);
+    if (tmp) fclose(tmp);
+    free(have);
+    return rc;
+}
+
 int main(int argc, char **argv) {
-    bool head = false;
-    const char *host = NULL, *port = NULL;
+    bool head = false, tail = false, mcast = false;
+    const char *host = NULL, *port = NULL, *offset = "-4096", *ifaddr = NULL;
 
     if (argc == 3) { host = argv[1]; port = argv[2]; }
     else if (argc == 4 && strcmp(argv[1], "--head") == 0) { head = true; host = argv[2]; port = argv[3]; }
+    else if ((argc == 4 || argc == 5) && strcmp(argv[1], "-f") == 0) {
+        tail = true; host = argv[2]; port = argv[3];
+        if (argc == 5) offset = argv[4];
+    }
+    else if ((argc == 4 || argc == 5) && strcmp(argv[1], "-m") == 0) {
+        mcast = true; host = argv[2]; port = argv[3];
+        if (argc == 5) ifaddr = argv[4];
+    }
     else {
-        fprintf(stderr, "Usage: %s <host> <port>\n       %s --head <host> <port>\n", argv[0], argv[0]);
+        fprintf(stderr, "Usage: %s <host> <port>\n       %s --head <host> <port>\n"
+                        "       %s -f <host> <port> [offset]\n       %s -m <host> <port> [ifaddr]\n",
+                argv[0], argv[0], argv[0], argv[0]);
         return 1;
     }
 
@@ -67,6 +328,12 @@ int main(int argc, char **argv) {
     freeaddrinfo(res);
     if (fd < 0) { perror("connect"); return 1; }
 
+    if (tail || mcast) {
+        int rc2 = tail ? follow(fd, offset) : mcast_receive(fd, ifaddr);
+        close(fd);
+        return rc2;
+    }
+
     const char *cmd = head ? "HEAD\n" : "GET\n";
     if (send_all(fd, cmd, strlen(cmd)) < 0) { perror("send"); close(fd); return 1; }
 
@@ -0,0 +1,594 @@
+// txtrelay.c — caching relay in front of a txtserve_multi origin
+// Speaks the multi-file protocol to clients and fetches from the upstream on a miss:
+//   LIST\n          -> forwarded to the upstream
+//   HEAD <name>\n   -> forwarded to the upstream
+//   WATCH\n, GREP ... -> piped to/from the upstream for as long as it answers
+//   GET  <name>\n   -> "ETAG <token>\nSIZE <n>\n\n" + <n bytes>, served from the cache
+// Cache:
+//   - Bodies live in <cache-dir>/<name>@<etag>, keyed by name + the ETAG the
+//     origin reports on HEAD. A GET for a cached name costs the origin one HEAD;
+//     the body only crosses the uplink when the token changed. If the origin
+//     can't answer that HEAD within REVALIDATE_TIMEOUT_S (it serves one client
+//     at a time), the cached copy is served as is. Each fetch fills its own
+//     <name>@<etag>.<seq>.part and renames it into place when complete.
+//   - Concurrent misses for the same name share one upstream fetch: a GET that
+//     finds the name still filling joins it without asking the origin. The
+//     fetch runs in its own thread and clients are served from the cache file
+//     while it is still filling, at their own pace.
+//   - A new version replaces the old entry; readers still streaming the old
+//     one keep their open descriptor. Completed files survive restarts.
+//   - Each reader opens the file for itself, so idle entries hold no descriptor.
+//     With -c, completed files beyond the byte cap are unlinked least recently
+//     used first; files a client is reading stay until the next trim.
+// Concurrency: thread-per-connection.
+
+#define _POSIX_C_SOURCE 200809L
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define NBUCKETS           1024
+#define UPSTREAM_TIMEOUT_S   30
+#define REVALIDATE_TIMEOUT_S 2
+
+enum { FILLING, DONE, FAILED };
+
+struct entry {
+    char name[256];
+    char etag[96];
+    char type[128];         // TYPE the origin sent with the body; empty if loaded from disk
+    char path[1024];
+    char part[1056];        // this fetch's own temp file, renamed to path when complete
+    int fd;                 // .part being filled; -1 before the header and once finished
+    long long size;         // -1 until the upstream header arrived
+    long long have;         // bytes written to the cache file so far
+    int state;
+    int refs;               // table slot + active readers + fetcher
+    unsigned long long used;// g_use_seq at the last GET, for LRU eviction
+    pthread_cond_t cond;    // signalled on every size/have/state change
+    struct entry *next;
+};
+
+static const char *g_up_host, *g_up_port, *g_cache_dir;
+static struct entry *g_table[NBUCKETS];
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned g_fetch_seq;   // makes every fetch's .part name unique
+static unsigned long long g_use_seq;
+static long long g_cache_cap = -1;   // -c, in bytes; -1 = unlimited
+static long long g_cache_bytes;      // sum of DONE entries in the table
+
+static int send_all(int fd, const void *buf, size_t len){
+    const char *p = (const char*)buf;
+    while (len){
+        ssize_t n = send(fd, p, len, 0);
+        if (n < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n; len -= (size_t)n;
+    }
+    return 0;
+}
+
+static ssize_t recv_line(int fd, char *buf, size_t maxlen){
+    size_t i = 0;
+    while (i + 1 < maxlen){
+        char c; ssize_t n = recv(fd, &c, 1, 0);
+        if (n == 0) break;
+        if (n < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf[i++] = c;
+        if (c == '\n') break;
+    }
+    buf[i] = '\0';
+    return (ssize_t)i;
+}
+
+static bool valid_name(const char *s){
+    if (*s == '\0') return false;
+    if (strstr(s, "..")) return false;
+    for (const char *p = s; *p; ++p){
+        if (*p == '/' || *p == '\\') return false;
+    }
+    return true;
+}
+
+// Truncating copy for header fields of unknown length
+static void copy_field(char *dst, size_t cap, const char *src){
+    size_t n = strnlen(src, cap - 1);
+    memcpy(dst, src, n); dst[n] = '\0';
+}
+
+static unsigned bucket_of(const char *name){
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (const unsigned char *p = (const unsigned char*)name; *p; ++p){ h ^= *p; h *= 16777619u; }
+    return h % NBUCKETS;
+}
+
+// ---- upstream ----
+
+static int upstream_connect(int timeout_s){
+    struct addrinfo hints, *res, *rp;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(g_up_host, g_up_port, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (rp = res; rp; rp = rp->ai_next){
+        fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, rp->ai_addr, (socklen_t)rp->ai_addrlen) == 0) break;
+        close(fd); fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd >= 0){
+        // A stalled origin fails the fetch instead of parking every waiting client forever
+        struct timeval tv = { timeout_s, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    return fd;
+}
+
+struct resp_hdr {
+    char type[128];
+    char etag[96];
+    long long size;
+    char err[256];          // upstream "ERR ..." line, forwarded verbatim
+    bool answered;          // err came from the origin, not from failing to reach it
+};
+
+// Sends "<cmd> <name>\n" and parses the header block.
+// Returns the connected socket, or -1 (h->err says why).
+static int upstream_request(const char *cmd, const char *name, struct resp_hdr *h, int timeout_s){
+    memset(h, 0, sizeof(*h));
+    h->size = -1;
+    int fd = upstream_connect(timeout_s);
+    if (fd < 0){ snprintf(h->err, sizeof(h->err), "ERR upstream unreachable\n"); return -1; }
+
+    char req[512];
+    int rn = snprintf(req, sizeof(req), "%s %s\n", cmd, name);
+    if (rn < 0 || (size_t)rn >= sizeof(req) || send_all(fd, req, (size_t)rn) < 0){
+        snprintf(h->err, sizeof(h->err), "ERR upstream send\n"); close(fd); return -1;
+    }
+    char line[512];
+    for (;;){
+        ssize_t n = recv_line(fd, line, sizeof(line));
+        if (n <= 0){ snprintf(h->err, sizeof(h->err), "ERR upstream closed\n"); close(fd); return -1; }
+        if (strcmp(line, "\n") == 0) break;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strncmp(line, "ERR ", 4) == 0){
+            copy_field(h->err, sizeof(h->err) - 1, line);
+            strcat(h->err, "\n");
+            h->answered = true;
+            close(fd); return -1;
+        }
+        else if (strncmp(line, "TYPE ", 5) == 0) copy_field(h->type, sizeof(h->type), line + 5);
+        else if (strncmp(line, "ETAG ", 5) == 0) copy_field(h->etag, sizeof(h->etag), line + 5);
+        else if (strncmp(line, "SIZE ", 5) == 0) h->size = strtoll(line + 5, NULL, 10);
+    }
+    if (h->size < 0 || h->etag[0] == '\0'){
+        snprintf(h->err, sizeof(h->err), "ERR upstream sent no SIZE/ETAG\n"); close(fd); return -1;
+    }
+    return fd;
+}
+
+static int send_headers(int cfd, const struct resp_hdr *h){
+    char hdr[320]; int n = 0;
+    if (h->type[0]) n += snprintf(hdr + n, sizeof(hdr) - (size_t)n, "TYPE %s\n", h->type);
+    n += snprintf(hdr + n, sizeof(hdr) - (size_t)n, "ETAG %s\nSIZE %lld\n\n", h->etag, h->size);
+    return send_all(cfd, hdr, (size_t)n);
+}
+
+// ---- cache table (all under g_lock) ----
+
+static struct entry *entry_new(const char *name, const char *etag){
+    struct entry *e = calloc(1, sizeof(*e));
+    if (!e) return NULL;
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    snprintf(e->etag, sizeof(e->etag), "%s", etag);
+    snprintf(e->path, sizeof(e->path), "%s/%s@%s", g_cache_dir, name, etag);
+    e->fd = -1; e->size = -1; e->state = FILLING;
+    pthread_cond_init(&e->cond, NULL);
+    return e;
+}
+
+static void entry_put(struct entry *e){
+    if (--e->refs > 0) return;
+    if (e->fd >= 0) close(e->fd);
+    pthread_cond_destroy(&e->cond);
+    free(e);
+}
+
+static struct entry *table_find(const char *name){
+    for (struct entry *e = g_table[bucket_of(name)]; e; e = e->next){
+        if (strcmp(e->name, name) == 0) return e;
+    }
+    return NULL;
+}
+
+// Drop the table's reference; the file goes now, open descriptors keep the data.
+static void table_remove(struct entry *e){
+    struct entry **pp = &g_table[bucket_of(e->name)];
+    while (*pp && *pp != e) pp = &(*pp)->next;
+    if (!*pp) return;
+    *pp = e->next;
+    if (e->state == DONE) g_cache_bytes -= e->size;
+    unlink(e->path);
+    entry_put(e);
+}
+
+static void table_insert(struct entry *e){
+    struct entry *old = table_find(e->name);
+    if (old) table_remove(old);
+    unsigned b = bucket_of(e->name);
+    e->next = g_table[b]; g_table[b] = e;
+    e->refs++;
+}
+
+// Pick up completed bodies left by a previous run; unfinished ones are useless.
+static void table_load(void){
+    DIR *d = opendir(g_cache_dir);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d))){
+        char path[1024];
+        int pn = snprintf(path, sizeof(path), "%s/%s", g_cache_dir, de->d_name);
+        if (pn < 0 || (size_t)pn >= sizeof(path)) continue;
+        size_t len = strlen(de->d_name);
+        if (len > 5 && strcmp(de->d_name + len - 5, ".part") == 0){ unlink(path); continue; }
+        char *at = strrchr(de->d_name, '@');
+        struct stat st;
+        if (!at || stat(path, &st) < 0 || !S_ISREG(st.st_mode)) continue;
+        *at = '\0';
+        if (!valid_name(de->d_name) || strlen(de->d_name) >= sizeof(((struct entry*)0)->name)) continue;
+        struct entry *old = table_find(de->d_name);
+        if (old){ unlink(path); continue; }   // two versions of one name: keep either, drop the other
+        struct entry *e = entry_new(de->d_name, at + 1);
+        if (!e) break;
+        e->size = e->have = (long long)st.st_size;
+        e->state = DONE;
+        table_insert(e);
+        g_cache_bytes += e->size;
+    }
+    closedir(d);
+}
+
+// Unlink least recently used files until the cache fits under -c.
+// Entries with a reader or a fetch in flight are skipped.
+static void cache_trim(void){
+    while (g_cache_cap >= 0 && g_cache_bytes > g_cache_cap){
+        struct entry *lru = NULL;
+        for (unsigned b = 0; b < NBUCKETS; b++){
+            for (struct entry *e = g_table[b]; e; e = e->next){
+                if (e->state == DONE && e->refs == 1 && (!lru || e->used < lru->used)) lru = e;
+            }
+        }
+        if (!lru) break;
+        table_remove(lru);
+    }
+}
+
+// ---- fetch: one thread per miss, fills the cache file at upstream speed ----
+
+static void fetch_finish(struct entry *e, int state){
+    pthread_mutex_lock(&g_lock);
+    if (e->fd >= 0){ close(e->fd); e->fd = -1; }   // readers have their own
+    bool current = table_find(e->name) == e;
+    if (!current){ if (e->part[0]) unlink(e->part); }   // superseded while filling
+    else if (state == DONE && rename(e->part, e->path) < 0) state = FAILED;
+    e->state = state;
+    if (state == FAILED){
+        if (e->part[0]) unlink(e->part);
+        table_remove(e);   // next request retries
+    }
+    else if (current){
+        g_cache_bytes += e->size;
+        cache_trim();
+    }
+    pthread_cond_broadcast(&e->cond);
+    entry_put(e);          // fetcher's reference
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void *fetch_thread(void *arg){
+    struct entry *e = arg;
+    struct resp_hdr h;
+    int ufd = upstream_request("GET", e->name, &h, UPSTREAM_TIMEOUT_S);
+    if (ufd < 0){ fetch_finish(e, FAILED); return NULL; }
+
+    // The file may have changed between the HEAD that keyed this entry and
+    // our GET: re-key to what the body actually is. Another entry may already
+    // be filling that version, so the temp name must not depend on name+etag alone.
+    pthread_mutex_lock(&g_lock);
+    if (strcmp(e->etag, h.etag) != 0){
+        snprintf(e->etag, sizeof(e->etag), "%s", h.etag);
+        snprintf(e->path, sizeof(e->path), "%s/%s@%s", g_cache_dir, e->name, h.etag);
+    }
+    snprintf(e->type, sizeof(e->type), "%s", h.type);
+    snprintf(e->part, sizeof(e->part), "%s.%u.part", e->path, ++g_fetch_seq);
+    char part[sizeof(e->part)];
+    memcpy(part, e->part, sizeof(part));
+    pthread_mutex_unlock(&g_lock);
+
+    int fd = open(part, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0){ close(ufd); fetch_finish(e, FAILED); return NULL; }
+
+    pthread_mutex_lock(&g_lock);
+    e->fd = fd;
+    e->size = h.size;
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&g_lock);
+
+    char buf[65536];
+    long long off = 0;
+    while (off < h.size){
+        size_t want = (h.size - off > (long long)sizeof(buf)) ? sizeof(buf) : (size_t)(h.size - off);
+        ssize_t n = recv(ufd, buf, want, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        for (ssize_t w = 0; w < n; ){
+            ssize_t k = pwrite(fd, buf + w, (size_t)(n - w), off + w);
+            if (k < 0){ if (errno == EINTR) continue; n = -1; break; }
+            w += k;
+        }
+        if (n < 0) break;
+        off += n;
+        pthread_mutex_lock(&g_lock);
+        e->have = off;
+        pthread_cond_broadcast(&e->cond);
+        pthread_mutex_unlock(&g_lock);
+    }
+    close(ufd);
+    fetch_finish(e, off == h.size ? DONE : FAILED);
+    return NULL;
+}
+
+// ---- client side ----
+
+static int do_get(int cfd, const char *name){
+    if (!valid_name(name)) return send_all(cfd, "ERR bad name\n", 13);
+
+    // A fetch still filling this name is as fresh as a HEAD could tell us, and
+    // the origin is busy sending it: join without a round trip.
+    pthread_mutex_lock(&g_lock);
+    struct entry *e = table_find(name);
+    bool joined = e && e->state == FILLING;
+    bool cached = e && e->state == DONE;
+    if (joined) e->refs++;   // us
+    pthread_mutex_unlock(&g_lock);
+
+    struct resp_hdr h;
+    memset(&h, 0, sizeof(h));
+    int ufd = -1;
+    if (!joined){
+        ufd = upstream_request("HEAD", name, &h, cached ? REVALIDATE_TIMEOUT_S : UPSTREAM_TIMEOUT_S);
+        if (ufd >= 0) close(ufd);
+    }
+
+    pthread_mutex_lock(&g_lock);
+    if (!joined) e = table_find(name);
+    if (!joined && ufd < 0 && (h.answered || !e || e->state == FAILED)){
+        pthread_mutex_unlock(&g_lock);
+        return send_all(cfd, h.err, strlen(h.err));
+    }
+    // An origin that couldn't answer in time leaves us with what we have.
+    if (!joined && ufd >= 0 && (!e || strcmp(e->etag, h.etag) != 0)){
+        e = entry_new(name, h.etag);
+        if (!e){ pthread_mutex_unlock(&g_lock); return send_all(cfd, "ERR oom\n", 8); }
+        table_insert(e);
+        e->refs++;   // fetcher
+        pthread_t t;
+        if (pthread_create(&t, NULL, fetch_thread, e) != 0){
+            e->refs--; e->state = FAILED; table_remove(e);
+            pthread_mutex_unlock(&g_lock);
+            return send_all(cfd, "ERR thread\n", 11);
+        }
+        pthread_detach(t);
+    }
+    if (!joined) e->refs++;   // us
+    e->used = ++g_use_seq;
+
+    while (e->state == FILLING && e->size < 0) pthread_cond_wait(&e->cond, &g_lock);
+    if (e->state == FAILED && e->size < 0){
+        entry_put(e);
+        pthread_mutex_unlock(&g_lock);
+        return send_all(cfd, "ERR upstream fetch failed\n", 26);
+    }
+    int fd = (e->fd >= 0) ? dup(e->fd) : open(e->path, O_RDONLY);   // still filling : complete
+    struct resp_hdr out = h;
+    if (!out.type[0]) snprintf(out.type, sizeof(out.type), "%s", e->type);
+    snprintf(out.etag, sizeof(out.etag), "%s", e->etag);
+    out.size = e->size;
+    pthread_mutex_unlock(&g_lock);
+
+    int rc = (fd < 0) ? send_all(cfd, "ERR cache open\n", 15) : send_headers(cfd, &out);
+    char buf[65536];
+    long long off = 0;
+    while (rc == 0 && fd >= 0 && off < out.size){
+        pthread_mutex_lock(&g_lock);
+        while (e->state == FILLING && e->have <= off) pthread_cond_wait(&e->cond, &g_lock);
+        long long have = e->have;
+        pthread_mutex_unlock(&g_lock);
+        if (have <= off){ rc = -1; break; }   // fetch failed midway: cut the client off
+
+        while (off < have){
+            size_t want = (have - off > (long long)sizeof(buf)) ? sizeof(buf) : (size_t)(have - off);
+            ssize_t n = pread(fd, buf, want, off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0 || send_all(cfd, buf, (size_t)n) < 0){ rc = -1; break; }
+            off += n;
+        }
+    }
+
+    if (fd >= 0) close(fd);
+    pthread_mutex_lock(&g_lock);
+    entry_put(e);
+    pthread_mutex_unlock(&g_lock);
+    return rc;
+}
+
+static int do_head(int cfd, const char *name){
+    if (!valid_name(name)) return send_all(cfd, "ERR bad name\n", 13);
+    struct resp_hdr h;
+    int ufd = upstream_request("HEAD", name, &h, UPSTREAM_TIMEOUT_S);
+    if (ufd < 0) return send_all(cfd, h.err, strlen(h.err));
+    close(ufd);
+    return send_headers(cfd, &h);
+}
+
+// LIST is small and always fresh: copy the upstream answer through.
+static int do_list(int cfd){
+    int ufd = upstream_connect(UPSTREAM_TIMEOUT_S);
+    if (ufd < 0) return send_all(cfd, "ERR upstream unreachable\n", 25);
+    int rc = send_all(ufd, "LIST\n", 5);
+    char buf[65536];
+    while (rc == 0){
+        ssize_t n = recv(ufd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        rc = send_all(cfd, buf, (size_t)n);
+        if (n >= 2 && buf[n-2] == '\n' && buf[n-1] == '\n') break;   // end of listing
+    }
+    close(ufd);
+    return rc;
+}
+
+// WATCH and GREP are answered by the origin: relay the command line, then
+// pipe both directions until the origin closes. A client hang-up is passed on
+// as a half-close, which ends a WATCH upstream just as it would directly.
+static int do_pipe(int cfd, const char *line){
+    int ufd = upstream_connect(UPSTREAM_TIMEOUT_S);
+    if (ufd < 0) return send_all(cfd, "ERR upstream unreachable\n", 25);
+    char req[520];
+    int rn = snprintf(req, sizeof(req), "%s\n", line);
+    int rc = (rn < 0 || (size_t)rn >= sizeof(req)) ? -1 : send_all(ufd, req, (size_t)rn);
+    char buf[65536];
+    int client = cfd;   // -1 once the client stopped sending
+    while (rc == 0){
+        struct pollfd pfd[2] = { { ufd, POLLIN, 0 }, { client, POLLIN, 0 } };
+        if (poll(pfd, 2, -1) < 0){ if (errno == EINTR) continue; rc = -1; break; }
+        if (pfd[1].revents){
+            ssize_t n = recv(cfd, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0){ shutdown(ufd, SHUT_WR); client = -1; }
+            else rc = send_all(ufd, buf, (size_t)n);
+        }
+        if (rc == 0 && pfd[0].revents){
+            ssize_t n = recv(ufd, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;   // origin done
+            rc = send_all(cfd, buf, (size_t)n);
+        }
+    }
+    close(ufd);
+    return rc;
+}
+
+static int serve_once(int cfd){
+    char line[512];
+    ssize_t rn = recv_line(cfd, line, sizeof(line));
+    if (rn <= 0) return -1;
+
+    // Strip CRLF
+    for (ssize_t i = 0; i < rn; i++){
+        if (line[i] == '\r' || line[i] == '\n'){ line[i] = '\0'; break; }
+    }
+
+    if      (strcmp(line, "LIST") == 0)          return do_list(cfd);
+    else if (strncmp(line, "GET ", 4)  == 0)     return do_get(cfd, line + 4);
+    else if (strncmp(line, "HEAD ", 5) == 0)     return do_head(cfd, line + 5);
+    else if (strcmp(line, "WATCH") == 0 ||
+             strncmp(line, "GREP ", 5) == 0)     return do_pipe(cfd, line);
+    else                                         return send_all(cfd, "ERR unknown command\n", 20);
+}
+
+static void *client_thread(void *arg){
+    int cfd = (int)(intptr_t)arg;
+    serve_once(cfd);
+    close(cfd);
+    return NULL;
+}
+
+int main(int argc, char **argv){
+    int opt;
+    bool bad = false;
+    while ((opt = getopt(argc, argv, "c:")) != -1){
+        if (opt == 'c') g_cache_cap = strtoll(optarg, NULL, 10) * 1024 * 1024;
+        else bad = true;
+    }
+    if (bad || argc - optind != 4 || g_cache_cap < -1){
+        fprintf(stderr, "Usage: %s [-c <cache-MiB>] <port> <upstream-host> <upstream-port> <cache-dir>\n", argv[0]);
+        return 1;
+    }
+    const char *port = argv[optind];
+    g_up_host = argv[optind + 1]; g_up_port = argv[optind + 2]; g_cache_dir = argv[optind + 3];
+
+    if (mkdir(g_cache_dir, 0755) < 0 && errno != EEXIST){ perror("mkdir cache-dir"); return 1; }
+    table_load();
+    cache_trim();
+
+    signal(SIGPIPE, SIG_IGN);   // a client leaving mid-body must not kill the relay
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;   // change to AF_INET6 for IPv6
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_PASSIVE;
+
+    int rc = getaddrinfo(NULL, port, &hints, &res);
+    if (rc != 0){
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(rc));
+        return 1;
+    }
+
+    int sfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sfd < 0){ perror("socket"); freeaddrinfo(res); return 1; }
+
+    int yes = 1;
+    setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    if (bind(sfd, res->ai_addr, (socklen_t)res->ai_addrlen) < 0){
+        perror("bind"); close(sfd); freeaddrinfo(res); return 1;
+    }
+    freeaddrinfo(res);
+
+    if (listen(sfd, 64) < 0){ perror("listen"); close(sfd); return 1; }
+
+    fprintf(stderr, "Relaying %s:%s on port %s (cache %s)\n", g_up_host, g_up_port, port, g_cache_dir);
+
+    for (;;){
+        struct sockaddr_storage ss;
+        socklen_t slen = sizeof(ss);
+        int cfd = accept(sfd, (struct sockaddr*)&ss, &slen);
+        if (cfd < 0){
+            if (errno == EINTR) continue;
+            perror("accept");
+            continue;
+        }
+        pthread_t t;
+        if (pthread_create(&t, NULL, client_thread, (void*)(intptr_t)cfd) != 0){
+            serve_once(cfd);   // no thread available — handle inline
+            close(cfd);
+            continue;
+        }
+        pthread_detach(t);
+    }
+}
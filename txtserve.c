@@ -2,30 +2,94 @@
 // Protocol (ASCII):
 //   Client: "GET\n" -> Server: "SIZE <n>\n\n" + <n raw bytes>
 //   Client: "HEAD\n" -> Server: "SIZE <n>\n\n"
+//   Client: "TAIL <offset>\n" -> Server: "FROM <start>\n\n" then, until the client hangs up:
+//           "DATA <n>\n" + <n raw bytes>   newly appended bytes
+//           "TRUNC <size>\n"              file shrank; streaming restarts at 0
+//           "ROTATE\n"                    path now names a new file; restarts at 0
+//           <offset> < 0 means "the last -offset bytes".
+//   Client: "MCAST\n" -> Server: "MCAST <group> <port> <size> <session> <chunk> <start-ms>\n\n"
+//           (only with -m). The file is then sent once to the UDP group; the
+//           connection stays open for "REPAIR <off> <len>\n" -> "DATA <len>\n" + bytes
+//           until the client sends "DONE\n" or hangs up.
+// Multicast datagrams (big-endian): u32 'TXM1', u32 session, u64 offset, payload.
+//   offset == ~0 marks the end of a round; its payload is the u64 file size.
 // Notes:
 //   - Re-reads the file on every request, so edits are reflected live.
-//   - Single-threaded, handles clients sequentially.
+//   - Single-threaded, handles clients sequentially; each TAIL follower gets
+//     a forked child driven by inotify (Linux), so it never blocks GET/HEAD.
+//   - With -m, MCAST receivers that arrive within the -w gather window share
+//     one paced multicast round (-r KiB/s), so egress is ~one copy plus repairs.
 //   - Listens on IPv6 by default with v4-mapped support (works for IPv4 and IPv6).
 
 #define _POSIX_C_SOURCE 200809L
+#define _DARWIN_C_SOURCE   // IN_MULTICAST, IP_MULTICAST_* (macOS)
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <libgen.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#define HAVE_INOTIFY 1
+#endif
 
 static volatile sig_atomic_t g_stop = 0;
 static void on_sigint(int signum) { (void)signum; g_stop = 1; }
 
+// Forked TAIL/MCAST helpers never look at g_stop: give them default
+// SIGINT/SIGTERM so Ctrl-C or kill ends them along with the server.
+static void child_signals(void) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGPIPE, SIG_IGN);
+    if (g_stop) _exit(0);   // stop arrived between fork() and the reset
+}
+static int g_listen_fd = -1;
+
+#define MCAST_MAGIC   0x54584d31u   // "TXM1"
+#define MCAST_HDR     16
+#define MCAST_CHUNK   1400          // payload per datagram; stays under a 1500-byte MTU
+#define MCAST_END     UINT64_MAX
+
+static struct {
+    bool enabled;
+    struct sockaddr_in group;
+    struct in_addr ifaddr;          // outgoing interface; INADDR_ANY = routing table
+    long long rate;                 // bytes/s
+    int window_ms;                  // gather window before a round starts
+} g_mc = { .rate = 8192 * 1024LL, .window_ms = 2000 };
+
+// Current round, owned by main; the SIGCHLD handler clears g_mc_pid.
+static volatile pid_t g_mc_pid = 0;
+static long long g_mc_start_ms;
+static uint32_t g_mc_session;
+static off_t g_mc_size;
+
+// Reap finished TAIL/MCAST children
+static void on_sigchld(int signum) {
+    (void)signum;
+    int saved = errno;
+    pid_t p;
+    while ((p = waitpid(-1, NULL, WNOHANG)) > 0) {
+        if (p == g_mc_pid) g_mc_pid = 0;
+    }
+    errno = saved;
+}
+
 static ssize_t read_line(int fd, char *buf, size_t maxlen) {
     size_t i = 0;
     while (i + 1 < maxlen) {
@@ -56,6 +120,317 @@ static int send_all(int fd, const void *buf, size_t len) {
     return 0;
 }
 
+#ifdef HAVE_INOTIFY
+// Send everything between *pos and the current end of fd as DATA frames.
+// A file that got shorter than *pos was truncated in place: say so and restart at 0.
+static int tail_send_new(int cfd, int fd, off_t *pos) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) return -1;
+    if (st.st_size < *pos) {
+        char msg[64];
+        int n = snprintf(msg, sizeof(msg), "TRUNC %lld\n", (long long)st.st_size);
+        if (send_all(cfd, msg, (size_t)n) < 0) return -1;
+        *pos = 0;
+    }
+    char buf[65536];
+    while (*pos < st.st_size) {
+        size_t want = (size_t)(st.st_size - *pos);
+        if (want > sizeof(buf)) want = sizeof(buf);
+        ssize_t got = pread(fd, buf, want, *pos);
+        if (got < 0) { if (errno == EINTR) continue; return -1; }
+        if (got == 0) break;
+        char hdr[32];
+        int hn = snprintf(hdr, sizeof(hdr), "DATA %zd\n", got);
+        if (send_all(cfd, hdr, (size_t)hn) < 0) return -1;
+        if (send_all(cfd, buf, (size_t)got) < 0) return -1;
+        *pos += got;
+    }
+    return 0;
+}
+
+// Runs in a forked child until the client disconnects. Wakes only on inotify
+// events for the file itself (writes, truncation, being moved/deleted) and for
+// its directory (a new file created or renamed onto the same name = rotation).
+static void follow_file(int cfd, const char *filepath, long long offset) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        char errbuf[256];
+        int n = snprintf(errbuf, sizeof(errbuf), "ERR cannot open file (%s)\n", strerror(errno));
+        send_all(cfd, errbuf, (size_t)n);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) { send_all(cfd, "ERR not a regular file\n", 23); close(fd); return; }
+
+    off_t pos;
+    if (offset < 0) pos = (offset <= -(long long)st.st_size) ? 0 : st.st_size + offset;   // no -offset: LLONG_MIN
+    else            pos = (offset > st.st_size) ? st.st_size : offset;
+
+    char dirbuf[1024], basebuf[1024];
+    snprintf(dirbuf, sizeof(dirbuf), "%s", filepath);
+    snprintf(basebuf, sizeof(basebuf), "%s", filepath);
+    const char *dir = dirname(dirbuf), *base = basename(basebuf);
+
+    int in = inotify_init1(IN_CLOEXEC);
+    const uint32_t file_mask = IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+    int wd_file = (in < 0) ? -1 : inotify_add_watch(in, filepath, file_mask);
+    int wd_dir  = (in < 0) ? -1 : inotify_add_watch(in, dir, IN_CREATE | IN_MOVED_TO);
+    if (wd_file < 0 || wd_dir < 0) {
+        char errbuf[256];
+        int n = snprintf(errbuf, sizeof(errbuf), "ERR inotify (%s)\n", strerror(errno));
+        send_all(cfd, errbuf, (size_t)n);
+        if (in >= 0) close(in);
+        close(fd);
+        return;
+    }
+
+    char header[64];
+    int hn = snprintf(header, sizeof(header), "FROM %lld\n\n", (long long)pos);
+    if (send_all(cfd, header, (size_t)hn) < 0 || tail_send_new(cfd, fd, &pos) < 0) goto out;
+
+    for (;;) {
+        struct pollfd pfd[2] = { { in, POLLIN, 0 }, { cfd, POLLIN, 0 } };
+        if (poll(pfd, 2, -1) < 0) { if (errno == EINTR) continue; break; }
+        if (pfd[1].revents) break;   // client sent something or hung up: done
+
+        char evbuf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t n = read(in, evbuf, sizeof(evbuf));
+        if (n <= 0) { if (n < 0 && errno == EINTR) continue; break; }
+        bool maybe_rotated = false;
+        for (char *p = evbuf; p < evbuf + n; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            if (ev->wd == wd_file && (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF))) maybe_rotated = true;
+            if (ev->wd == wd_dir && ev->len > 0 && strcmp(ev->name, base) == 0) maybe_rotated = true;
+            if (ev->mask & IN_Q_OVERFLOW) maybe_rotated = true;
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+
+        // Whatever the old file got before it was replaced still belongs to the stream.
+        if (tail_send_new(cfd, fd, &pos) < 0) break;
+
+        if (maybe_rotated) {
+            int nfd = open(filepath, O_RDONLY);
+            struct stat nst;
+            if (nfd < 0) continue;   // moved away, replacement not created yet
+            if (fstat(nfd, &nst) < 0 || (nst.st_ino == st.st_ino && nst.st_dev == st.st_dev)) { close(nfd); continue; }
+            close(fd);
+            fd = nfd; st = nst; pos = 0;
+            inotify_rm_watch(in, wd_file);
+            wd_file = inotify_add_watch(in, filepath, file_mask);
+            if (send_all(cfd, "ROTATE\n", 7) < 0 || tail_send_new(cfd, fd, &pos) < 0) break;
+        }
+    }
+out:
+    close(in);
+    close(fd);
+}
+#endif
+
+static int do_tail(int cfd, const char *filepath, const char *arg) {
+#ifdef HAVE_INOTIFY
+    char *end;
+    errno = 0;
+    long long offset = strtoll(arg, &end, 10);
+    if (end == arg || *end != '\0' || errno) { send_all(cfd, "ERR bad offset\n", 15); return 0; }
+
+    pid_t pid = fork();
+    if (pid < 0) { send_all(cfd, "ERR fork\n", 9); return 0; }
+    if (pid == 0) {
+        close(g_listen_fd);
+        child_signals();
+        follow_file(cfd, filepath, offset);
+        close(cfd);
+        _exit(0);
+    }
+    return 0;   // parent: main loop closes its copy of cfd
+#else
+    (void)filepath; (void)arg;
+    const char *msg = "ERR tail unsupported\n";
+    send_all(cfd, msg, strlen(msg));
+    return 0;
+#endif
+}
+
+// ---- MCAST: one paced UDP copy for everyone, repairs over TCP ----
+
+static long long mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) { p[i] = (unsigned char)(v & 0xff); v >>= 8; }
+}
+
+// Identifies one version of the file, so receivers never mix rounds of different contents.
+static uint32_t mcast_session(const struct stat *st) {
+    uint64_t v[3] = { (uint64_t)st->st_ino, (uint64_t)st->st_size, (uint64_t)st->st_mtime };
+    uint32_t h = 2166136261u;   // FNV-1a
+    const unsigned char *b = (const unsigned char *)v;
+    for (size_t i = 0; i < sizeof(v); i++) { h ^= b[i]; h *= 16777619u; }
+    return h;
+}
+
+// Sender child: wait out the gather window, then send the first size bytes of
+// fd (the version the round was scheduled for) once at g_mc.rate.
+static void mcast_round(int fd, off_t size, uint32_t session) {
+    struct timespec gather = { g_mc.window_ms / 1000, (long)(g_mc.window_ms % 1000) * 1000000L };
+    while (nanosleep(&gather, &gather) < 0 && errno == EINTR) { /* resume */ }
+
+    int us = socket(AF_INET, SOCK_DGRAM, 0);
+    if (us < 0) return;
+    unsigned char ttl = 1, loop = 1;
+    setsockopt(us, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(us, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    if (g_mc.ifaddr.s_addr != htonl(INADDR_ANY))
+        setsockopt(us, IPPROTO_IP, IP_MULTICAST_IF, &g_mc.ifaddr, sizeof(g_mc.ifaddr));
+
+    unsigned char pkt[MCAST_HDR + MCAST_CHUNK];
+    uint32_t magic = htonl(MCAST_MAGIC), sess = htonl(session);
+    memcpy(pkt, &magic, 4);
+    memcpy(pkt + 4, &sess, 4);
+
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint64_t off = 0;
+    while (off < (uint64_t)size) {
+        size_t want = ((uint64_t)size - off < MCAST_CHUNK) ? (size_t)((uint64_t)size - off) : MCAST_CHUNK;
+        ssize_t got = pread(fd, pkt + MCAST_HDR, want, (off_t)off);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        put_u64(pkt + 8, off);
+        if (sendto(us, pkt, MCAST_HDR + (size_t)got, 0, (struct sockaddr *)&g_mc.group, sizeof(g_mc.group)) < 0 &&
+            errno != ENOBUFS) break;   // ENOBUFS: dropped locally, receivers repair it
+        off += (uint64_t)got;
+
+        // Pace: stay on the line "off bytes by off/rate seconds"; sleep once >=1 ms ahead.
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long elapsed_ns = (now.tv_sec - t0.tv_sec) * 1000000000LL + (now.tv_nsec - t0.tv_nsec);
+        uint64_t rate = (uint64_t)g_mc.rate;   // split so off * 1e9 can't wrap past ~18 GB
+        long long due_ns = (long long)(off / rate * 1000000000ULL + off % rate * 1000000000ULL / rate);
+        if (due_ns - elapsed_ns >= 1000000) {
+            long long d = due_ns - elapsed_ns;
+            struct timespec ts = { (time_t)(d / 1000000000LL), (long)(d % 1000000000LL) };
+            while (nanosleep(&ts, &ts) < 0 && errno == EINTR) { /* resume */ }
+        }
+    }
+
+    // End marker, repeated because it is as lossy as everything else
+    put_u64(pkt + 8, MCAST_END);
+    put_u64(pkt + MCAST_HDR, (uint64_t)size);   // short read (file shrank): receivers repair the rest
+    for (int i = 0; i < 3; i++)
+        sendto(us, pkt, MCAST_HDR + 8, 0, (struct sockaddr *)&g_mc.group, sizeof(g_mc.group));
+    close(us);
+}
+
+// Repair child: serve byte ranges the receiver missed until it is done.
+static void mcast_repairs(int cfd, int fd, off_t size) {
+    char line[128], buf[65536];
+    while (read_line(cfd, line, sizeof(line)) > 0) {
+        long long off, len;
+        if (strncmp(line, "DONE", 4) == 0) break;
+        if (sscanf(line, "REPAIR %lld %lld", &off, &len) != 2 || off < 0 || len < 0 || off > size || len > size - off) {
+            send_all(cfd, "ERR bad range\n", 14);
+            break;
+        }
+        char hdr[32];
+        int hn = snprintf(hdr, sizeof(hdr), "DATA %lld\n", len);
+        if (send_all(cfd, hdr, (size_t)hn) < 0) break;
+        while (len > 0) {
+            size_t want = (len > (long long)sizeof(buf)) ? sizeof(buf) : (size_t)len;
+            ssize_t got = pread(fd, buf, want, (off_t)off);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) { memset(buf, 0, want); got = (ssize_t)want; }   // file shrank: keep framing
+            if (send_all(cfd, buf, (size_t)got) < 0) return;
+            off += got; len -= got;
+        }
+    }
+}
+
+static int do_mcast(int cfd, const char *filepath) {
+    if (!g_mc.enabled) { const char *msg = "ERR multicast off\n"; send_all(cfd, msg, strlen(msg)); return 0; }
+
+    int fd = open(filepath, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        if (fd >= 0) close(fd);
+        send_all(cfd, "ERR cannot open file\n", 21);
+        return 0;
+    }
+
+    // Join the pending/running round, or schedule a new one after the gather window.
+    // The sender inherits this fd, so the round sends exactly the version it was
+    // scheduled for; a receiver that sees a different version can't join it.
+    // SIGCHLD stays blocked so a quick sender can't be reaped before its pid is recorded.
+    uint32_t session = mcast_session(&st);
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block, &old);
+    if (g_mc_pid == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            sigprocmask(SIG_SETMASK, &old, NULL);
+            child_signals();
+            close(g_listen_fd); close(cfd);
+            mcast_round(fd, st.st_size, session);
+            close(fd);
+            _exit(0);
+        }
+        if (pid > 0) {
+            g_mc_pid = pid; g_mc_session = session; g_mc_size = st.st_size;
+            g_mc_start_ms = mono_ms() + g_mc.window_ms;
+        }
+    }
+    bool running = g_mc_pid != 0;
+    bool same = running && g_mc_session == session && g_mc_size == st.st_size;
+    long long start_in = g_mc_start_ms - mono_ms();
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    if (!running) { close(fd); send_all(cfd, "ERR fork\n", 9); return 0; }
+    if (!same) {
+        close(fd);
+        const char *msg = "ERR mcast busy with another version of the file, retry\n";
+        send_all(cfd, msg, strlen(msg));
+        return 0;
+    }
+
+    char group[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &g_mc.group.sin_addr, group, sizeof(group));
+    char hdr[160];
+    int hn = snprintf(hdr, sizeof(hdr), "MCAST %s %u %lld %u %d %lld\n\n", group, ntohs(g_mc.group.sin_port),
+                      (long long)st.st_size, session, MCAST_CHUNK, start_in > 0 ? start_in : 0);
+    if (send_all(cfd, hdr, (size_t)hn) < 0) { close(fd); return -1; }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(g_listen_fd);
+        child_signals();
+        mcast_repairs(cfd, fd, st.st_size);
+        close(cfd);
+        _exit(0);
+    }
+    close(fd);
+    if (pid < 0) send_all(cfd, "ERR fork\n", 9);
+    return 0;   // parent: main loop closes its copy of cfd
+}
+
+// -m <group>:<port>
+static bool parse_group(const char *arg, struct sockaddr_in *out) {
+    char host[64];
+    const char *colon = strrchr(arg, ':');
+    if (!colon || (size_t)(colon - arg) >= sizeof(host)) return false;
+    memcpy(host, arg, (size_t)(colon - arg));
+    host[colon - arg] = '\0';
+    long port = strtol(colon + 1, NULL, 10);
+    memset(out, 0, sizeof(*out));
+    out->sin_family = AF_INET;
+    out->sin_port = htons((uint16_t)port);
+    return port > 0 && port < 65536 && inet_pton(AF_INET, host, &out->sin_addr) == 1 &&
+           IN_MULTICAST(ntohl(out->sin_addr.s_addr));
+}
+
 static int serve_once(int cfd, const char *filepath) {
     // Read command line (up to 16 bytes is plenty)
     char cmd[32];
@@ -67,6 +442,9 @@ static int serve_once(int cfd, const char *filepath) {
         if (cmd[i] == '\r' || cmd[i] == '\n') { cmd[i] = '\0'; break; }
     }
 
+    if (strncmp(cmd, "TAIL ", 5) == 0) return do_tail(cfd, filepath, cmd + 5);
+    if (strcmp(cmd, "MCAST") == 0) return do_mcast(cfd, filepath);
+
     bool want_body = false;
     if (strcmp(cmd, "GET") == 0) want_body = true;
     else if (strcmp(cmd, "HEAD") == 0) want_body = false;
@@ -113,16 +491,40 @@ static int serve_once(int cfd, const char *filepath) {
 }
 
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <port> <path-to-text-file>\n", argv[0]);
+    int opt;
+    bool bad = false;
+    while ((opt = getopt(argc, argv, "m:r:w:i:")) != -1) {
+        switch (opt) {
+        case 'm':
+            if (!parse_group(optarg, &g_mc.group)) { fprintf(stderr, "bad multicast group: %s\n", optarg); return 1; }
+            g_mc.enabled = true;
+            break;
+        case 'r': g_mc.rate = strtoll(optarg, NULL, 10) * 1024; break;
+        case 'w': g_mc.window_ms = atoi(optarg); break;
+        case 'i':
+            if (inet_pton(AF_INET, optarg, &g_mc.ifaddr) != 1) { fprintf(stderr, "bad interface address: %s\n", optarg); return 1; }
+            break;
+        default: bad = true; break;
+        }
+    }
+    if (bad || argc - optind != 2 || g_mc.rate <= 0 || g_mc.window_ms < 0) {
+        fprintf(stderr, "Usage: %s [-m <group>:<port> [-r <KiB/s>] [-w <gather-ms>] [-i <if-addr>]] <port> <path-to-text-file>\n",
+                argv[0]);
         return 1;
     }
-    const char *port = argv[1];
-    const char *filepath = argv[2];
+    const char *port = argv[optind];
+    const char *filepath = argv[optind + 1];
 
     signal(SIGINT, on_sigint);
     signal(SIGTERM, on_sigint);
 
+    struct sigaction sa_chld;
+    memset(&sa_chld, 0, sizeof(sa_chld));
+    sa_chld.sa_handler = on_sigchld;
+    sigemptyset(&sa_chld.sa_mask);
+    sa_chld.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa_chld, NULL);
+
     struct addrinfo hints, *res = NULL;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_INET6;
@@ -137,6 +539,7 @@ int main(int argc, char **argv) {
 
     int sfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
     if (sfd < 0) { perror("socket"); freeaddrinfo(res); return 1; }
+    g_listen_fd = sfd;
 
     // Allow IPv4-mapped on IPv6 socket (default is usually 0 on macOS, but be explicit)
     int v6only = 0;
@@ -156,6 +559,12 @@ int main(int argc, char **argv) {
     if (listen(sfd, 16) < 0) { perror("listen"); close(sfd); return 1; }
 
     fprintf(stderr, "Serving %s on port %s (Ctrl-C to stop)\n", filepath, port);
+    if (g_mc.enabled) {
+        char group[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &g_mc.group.sin_addr, group, sizeof(group));
+        fprintf(stderr, "MCAST to %s:%u at %lld KiB/s, %d ms gather window\n",
+                group, ntohs(g_mc.group.sin_port), g_mc.rate / 1024, g_mc.window_ms);
+    }
 
     while (!g_stop) {
         struct sockaddr_storage ss;
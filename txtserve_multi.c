@@ -1,26 +1,78 @@
 // txtserve_multi.c — serve files by name from a directory root, plus LIST
 // Protocol:
 //   LIST\n                  -> "FILES <n>\n<name>\t<size>\n...\n\n"
-//   GET  <name>\n          -> "SIZE <n>\n\n" + <n bytes>
-//   HEAD <name>\n          -> "SIZE <n>\n\n"
+//   GET  <name>\n          -> "ETAG <token>\nSIZE <n>\n\n" + <n bytes>
+//   HEAD <name>\n          -> "ETAG <token>\nSIZE <n>\n\n"
+//   WATCH\n                 -> "WATCHING\n\n" then a stream of event lines:
+//                              "ADD <name>\t<size>\n", "MOD <name>\t<size>\n",
+//                              "DEL <name>\n", or "RESYNC\n" (re-LIST needed)
 // Notes: <name> must be a simple filename (no '/' or "..").
+//        ETAG changes whenever the file is replaced or rewritten (inode, size,
+//        mtime); caches such as txtrelay key bodies on it.
+//        WATCH needs inotify (Linux); one shared watch feeds all subscribers,
+//        bursts are coalesced and each subscriber has a bounded backlog.
+//   GREP [-n] [-m <max>] <name>\t<pattern>\n
+//                           -> "MATCHES <k>\nSIZE <n>\n\n" + <n bytes>: the k matching
+//                              lines, each '\n'-terminated, "<lineno>:"-prefixed with -n.
+//                              <pattern> is a literal; a leading '^' / trailing '$'
+//                              anchors it to the start / end of the line.
+//        GREP scans the mapped file with AVX2/SSE2 on x86 (scalar elsewhere),
+//        so the reply is sized by the matches, not the file.
+// Options:
+//   -u  io_uring backend (Linux): accepts, file reads and socket writes go
+//       through one ring with registered buffers/fds and URING_QD reads in
+//       flight per transfer. Falls back to read()/send() when the kernel
+//       lacks io_uring or any op it needs.
+//   --bench-grep <file> <pattern>
+//       Time each GREP scanner against memchr() over the mapped file, then exit.
 
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE   // syscall() for io_uring (glibc)
 #include <arpa/inet.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <setjmp.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#define HAVE_INOTIFY 1
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define HAVE_URING 1
+#endif
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+#define MAX_WATCHERS      64
+#define WATCH_BACKLOG     16384   // queued event bytes per subscriber before RESYNC
+#define WATCH_COALESCE_MS 100     // burst window: events within it collapse per name
+#define MAX_PENDING       256     // distinct names per window before RESYNC
+#define KEEP_OPEN         1       // serve_once(): connection handed to the watcher set
+#define URING_QD          8       // disk reads in flight per transfer
+#define URING_BUF         (128*1024)
+#define URING_RETRIES     100     // 1 ms apart, for EAGAIN/EBUSY from io_uring_enter
+#define GREP_OUTBUF       65536   // reply lines are batched into sends of this size
 
 static volatile sig_atomic_t g_stop = 0;
 static void on_sigint(int signum){(void)signum; g_stop = 1;}
@@ -51,6 +103,15 @@ static bool valid_name(const char *s){
     return true;
 }
 
+static void etag_of(const struct stat *st, char *out, size_t n){
+    long long nsec = 0;
+#ifdef __linux__
+    nsec = (long long)st->st_mtim.tv_nsec;
+#endif
+    snprintf(out,n,"%llx-%llx-%llx.%llx",(unsigned long long)st->st_ino,(unsigned long long)st->st_size,
+             (unsigned long long)st->st_mtime,(unsigned long long)nsec);
+}
+
 static int do_list(int cfd, const char *rootdir){
     DIR *d = opendir(rootdir);
     if(!d){ char e[256]; int n=snprintf(e,sizeof(e),"ERR opendir (%s)\n", strerror(errno));
@@ -84,12 +145,240 @@ static int do_list(int cfd, const char *rootdir){
     return 0;
 }
 
+// ---- io_uring backend (-u) ----
+#ifdef HAVE_URING
+enum { SLOT_FILE, SLOT_SOCK, SLOT_LISTEN, NSLOTS };          // registered file table
+enum { UD_READ = 1, UD_WRITE, UD_ACCEPT };                   // user_data >> 32
+enum { B_FREE, B_READING, B_READY, B_WRITING };
+
+static struct {
+    int fd;                        // ring; -1 = backend off
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_entries, *sq_array, sq_local_tail;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *maps[3]; size_t map_len[3];   // SQ ring, CQ ring (unless shared), SQE array
+    char *bufs;                    // URING_QD x URING_BUF, registered
+    bool accept_armed;
+    int accepted;                  // accept completion reaped during a transfer; -1 none
+} g_ur = { .fd = -1, .accepted = -1 };
+
+static int ur_enter(unsigned to_submit, unsigned min_complete, unsigned flags){
+    return (int)syscall(__NR_io_uring_enter,g_ur.fd,to_submit,min_complete,flags,NULL,0);
+}
+static int ur_register(unsigned op, void *arg, unsigned n){
+    return (int)syscall(__NR_io_uring_register,g_ur.fd,op,arg,n);
+}
+
+static bool ur_probe(const int *ops, int n){
+    size_t sz = sizeof(struct io_uring_probe) + 256*sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *pr = calloc(1,sz);
+    if(!pr) return false;
+    bool ok = ur_register(IORING_REGISTER_PROBE,pr,256)==0;
+    for(int i=0; ok && i<n; i++)
+        ok = ops[i]<=pr->last_op && (pr->ops[ops[i]].flags & IO_URING_OP_SUPPORTED);
+    free(pr);
+    if(!ok && errno==0) errno = EOPNOTSUPP;
+    return ok;
+}
+
+// Set up the ring, register buffers and the fd table. On any failure the
+// server keeps using the plain path (errno says why).
+static bool ur_init(int sfd){
+    struct io_uring_params p; memset(&p,0,sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup,64,&p);
+    if(fd<0) return false;
+    g_ur.fd = fd;
+
+    size_t sq_len = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+    size_t cq_len = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP)!=0;
+    if(single){ if(cq_len>sq_len) sq_len=cq_len; cq_len=sq_len; }
+    char *sq = mmap(NULL,sq_len,PROT_READ|PROT_WRITE,MAP_SHARED,fd,IORING_OFF_SQ_RING);
+    char *cq = single ? sq : mmap(NULL,cq_len,PROT_READ|PROT_WRITE,MAP_SHARED,fd,IORING_OFF_CQ_RING);
+    void *sqes = mmap(NULL,p.sq_entries*sizeof(struct io_uring_sqe),PROT_READ|PROT_WRITE,MAP_SHARED,fd,IORING_OFF_SQES);
+    if(sq==MAP_FAILED || cq==MAP_FAILED || sqes==MAP_FAILED) goto fail;   // process-lifetime maps; not unmapped
+    g_ur.maps[0] = sq; g_ur.map_len[0] = sq_len;
+    if(!single){ g_ur.maps[1] = cq; g_ur.map_len[1] = cq_len; }
+    g_ur.maps[2] = sqes; g_ur.map_len[2] = p.sq_entries*sizeof(struct io_uring_sqe);
+
+    g_ur.sq_head = (unsigned*)(sq+p.sq_off.head);   g_ur.sq_tail = (unsigned*)(sq+p.sq_off.tail);
+    g_ur.sq_mask = (unsigned*)(sq+p.sq_off.ring_mask); g_ur.sq_entries = (unsigned*)(sq+p.sq_off.ring_entries);
+    g_ur.sq_array = (unsigned*)(sq+p.sq_off.array); g_ur.sq_local_tail = *g_ur.sq_tail;
+    g_ur.sqes = sqes;
+    g_ur.cq_head = (unsigned*)(cq+p.cq_off.head);   g_ur.cq_tail = (unsigned*)(cq+p.cq_off.tail);
+    g_ur.cq_mask = (unsigned*)(cq+p.cq_off.ring_mask);
+    g_ur.cqes = (struct io_uring_cqe*)(cq+p.cq_off.cqes);
+
+    const int need[] = { IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED, IORING_OP_ACCEPT };
+    if(!ur_probe(need,(int)(sizeof(need)/sizeof(need[0])))) goto fail;
+
+    if(posix_memalign((void**)&g_ur.bufs,4096,(size_t)URING_QD*URING_BUF)!=0){ errno=ENOMEM; goto fail; }
+    struct iovec iov[URING_QD];
+    for(int i=0;i<URING_QD;i++){ iov[i].iov_base = g_ur.bufs+(size_t)i*URING_BUF; iov[i].iov_len = URING_BUF; }
+    if(ur_register(IORING_REGISTER_BUFFERS,iov,URING_QD)<0) goto fail;
+
+    int fds[NSLOTS] = { -1, -1, sfd };
+    if(ur_register(IORING_REGISTER_FILES,fds,NSLOTS)<0) goto fail;
+    return true;
+fail:;
+    int e = errno;
+    close(fd); g_ur.fd = -1;
+    free(g_ur.bufs); g_ur.bufs = NULL;
+    errno = e;
+    return false;
+}
+
+// Next free SQE, zeroed; published to the kernel by ur_submit().
+static struct io_uring_sqe *ur_sqe(void){
+    unsigned head = __atomic_load_n(g_ur.sq_head,__ATOMIC_ACQUIRE);
+    if(g_ur.sq_local_tail - head >= *g_ur.sq_entries) return NULL;
+    unsigned idx = g_ur.sq_local_tail++ & *g_ur.sq_mask;
+    g_ur.sq_array[idx] = idx;
+    memset(&g_ur.sqes[idx],0,sizeof(g_ur.sqes[idx]));
+    return &g_ur.sqes[idx];
+}
+
+// Submit everything queued in one syscall, optionally waiting for a completion.
+// Transient EAGAIN/EBUSY get URING_RETRIES tries; anything else is fatal to the ring.
+static int ur_submit(unsigned wait_nr){
+    __atomic_store_n(g_ur.sq_tail,g_ur.sq_local_tail,__ATOMIC_RELEASE);
+    for(int tries=0;;){
+        unsigned pending = g_ur.sq_local_tail - __atomic_load_n(g_ur.sq_head,__ATOMIC_ACQUIRE);
+        if(pending==0 && wait_nr==0) return 0;
+        int r = ur_enter(pending,wait_nr,wait_nr ? IORING_ENTER_GETEVENTS : 0);
+        if(r>=0) return 0;
+        if(g_stop) return -1;
+        if(errno==EINTR) continue;
+        if((errno!=EAGAIN && errno!=EBUSY) || ++tries>=URING_RETRIES) return -1;
+        struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts,NULL);
+    }
+}
+
+static bool ur_cqe(uint64_t *ud, int *res){
+    unsigned head = *g_ur.cq_head;
+    if(head == __atomic_load_n(g_ur.cq_tail,__ATOMIC_ACQUIRE)) return false;
+    struct io_uring_cqe *c = &g_ur.cqes[head & *g_ur.cq_mask];
+    *ud = c->user_data; *res = c->res;
+    __atomic_store_n(g_ur.cq_head,head+1,__ATOMIC_RELEASE);
+    return true;
+}
+
+static void ur_on_accept(int res){
+    g_ur.accept_armed = false;
+    if(res>=0) g_ur.accepted = res;
+    else if(res!=-EINTR && res!=-ECONNABORTED && res!=-ECANCELED){ errno=-res; perror("accept"); }
+}
+
+// The ring failed hard: tear it down, which cancels whatever is still queued
+// or in flight (a pending accept leaves its connection in the listen backlog),
+// and carry on with accept()/read()/send(). The kernel only tears a ring down
+// once it is unmapped as well as closed. The registered buffers stay
+// allocated since cancellation finishes asynchronously.
+static void ur_abandon(void){
+    fprintf(stderr,"io_uring failed (%s), falling back to read()/send()\n",strerror(errno));
+    uint64_t ud; int res;
+    while(ur_cqe(&ud,&res)) if((ud>>32)==UD_ACCEPT) ur_on_accept(res);   // a finished accept owns a connection
+    for(int i=0;i<3;i++) if(g_ur.maps[i]){ munmap(g_ur.maps[i],g_ur.map_len[i]); g_ur.maps[i] = NULL; }
+    close(g_ur.fd); g_ur.fd = -1;
+    g_ur.accept_armed = false;
+}
+
+// One accept in flight at most, and none while a completed one is parked,
+// so a second completion can never overwrite g_ur.accepted.
+static void ur_arm_accept(void){
+    if(g_ur.accept_armed || g_ur.accepted>=0) return;
+    struct io_uring_sqe *sqe = ur_sqe();
+    if(!sqe) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = SLOT_LISTEN; sqe->flags = IOSQE_FIXED_FILE;
+    sqe->user_data = (uint64_t)UD_ACCEPT<<32;
+    if(ur_submit(0)==0) g_ur.accept_armed = true;
+    else if(!g_stop) ur_abandon();
+}
+
+// Body of a GET: keep URING_QD fixed-buffer reads in flight ahead of one
+// in-order socket write, resubmitting short writes. Returns -2 if the ring
+// can't take this transfer (caller falls back), -1 on I/O error or when the
+// ring itself failed (it is abandoned; the client is cut off mid-body).
+static int ur_send_file(int cfd, int fd, long long size){
+    int upd[2] = { fd, cfd };
+    struct io_uring_files_update fu; memset(&fu,0,sizeof(fu));
+    fu.offset = SLOT_FILE; fu.fds = (uint64_t)(uintptr_t)upd;
+    if(ur_register(IORING_REGISTER_FILES_UPDATE,&fu,2)<0) return -2;
+    posix_fadvise(fd,0,0,POSIX_FADV_SEQUENTIAL);   // bigger readahead behind the queued reads
+
+    struct { long long off; unsigned len, sent; int state; } b[URING_QD];
+    memset(b,0,sizeof(b));
+    long long read_off=0, send_off=0;
+    int inflight=0; bool writing=false, failed=false;
+
+    while(inflight>0 || (!failed && send_off<size)){
+        if(!failed){
+            for(int i=0;i<URING_QD && read_off<size;i++){
+                if(b[i].state!=B_FREE) continue;
+                struct io_uring_sqe *sqe = ur_sqe();
+                if(!sqe) break;
+                b[i].off = read_off; b[i].sent = 0;
+                b[i].len = (unsigned)((size-read_off > URING_BUF) ? URING_BUF : size-read_off);
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->fd = SLOT_FILE; sqe->flags = IOSQE_FIXED_FILE;
+                sqe->addr = (uint64_t)(uintptr_t)(g_ur.bufs+(size_t)i*URING_BUF);
+                sqe->len = b[i].len; sqe->off = (uint64_t)read_off; sqe->buf_index = (uint16_t)i;
+                sqe->user_data = ((uint64_t)UD_READ<<32) | (unsigned)i;
+                b[i].state = B_READING; read_off += b[i].len; inflight++;
+            }
+            for(int i=0;i<URING_QD && !writing;i++){
+                if(b[i].state!=B_READY || b[i].off+b[i].sent!=send_off) continue;
+                struct io_uring_sqe *sqe = ur_sqe();
+                if(!sqe) break;
+                sqe->opcode = IORING_OP_WRITE_FIXED;
+                sqe->fd = SLOT_SOCK; sqe->flags = IOSQE_FIXED_FILE;
+                sqe->addr = (uint64_t)(uintptr_t)(g_ur.bufs+(size_t)i*URING_BUF+b[i].sent);
+                sqe->len = b[i].len-b[i].sent; sqe->buf_index = (uint16_t)i;
+                sqe->user_data = ((uint64_t)UD_WRITE<<32) | (unsigned)i;
+                b[i].state = B_WRITING; writing = true; inflight++;
+            }
+        }
+        if(inflight==0) break;
+        if(ur_submit(1)<0){
+            shutdown(cfd,SHUT_RDWR);   // nothing more of this body may reach the client
+            if(!g_stop) ur_abandon();
+            return -1;
+        }
+
+        uint64_t ud; int res;
+        while(ur_cqe(&ud,&res)){
+            int kind = (int)(ud>>32), i = (int)(ud & 0xffffffffu);
+            if(kind==UD_ACCEPT){ ur_on_accept(res); continue; }
+            inflight--;
+            if(kind==UD_READ){
+                if(res!=(int)b[i].len){ failed=true; b[i].state=B_FREE; continue; }   // error or file shrank
+                b[i].state = failed ? B_FREE : B_READY;
+            } else {
+                writing = false;
+                if(res<=0){ failed=true; b[i].state=B_FREE; continue; }
+                b[i].sent += (unsigned)res; send_off += res;
+                b[i].state = (b[i].sent==b[i].len || failed) ? B_FREE : B_READY;
+            }
+        }
+    }
+
+    // The table holds its own references; drop them so the file really closes.
+    int clr[2] = { -1, -1 };
+    fu.fds = (uint64_t)(uintptr_t)clr;
+    ur_register(IORING_REGISTER_FILES_UPDATE,&fu,2);
+    return failed ? -1 : 0;
+}
+#endif
+
 static int do_send_file(int cfd, const char *rootdir, const char *name, bool want_body){
     if(!valid_name(name)) return send_all(cfd,"ERR bad name\n",13);
 
     char path[1024];
     int pn = snprintf(path,sizeof(path),"%s/%s",rootdir,name);
-    if(pn<0 || (size_t)pn>=sizeof(path)) return send_all(cfd,"ERR name too long\n",19);
+    if(pn<0 || (size_t)pn>=sizeof(path)) return send_all(cfd,"ERR name too long\n",18);
 
     int fd = open(path,O_RDONLY);
     if(fd<0){ char e[256]; int n=snprintf(e,sizeof(e),"ERR open (%s)\n", strerror(errno)); return send_all(cfd,e,(size_t)n); }
@@ -98,9 +387,16 @@ static int do_send_file(int cfd, const char *rootdir, const char *name, bool wan
     if(fstat(fd,&st)<0 || !S_ISREG(st.st_mode)){ close(fd); return send_all(cfd,"ERR not file\n",13); }
 
     long long size = (long long)st.st_size;
-    char hdr[64]; int hn = snprintf(hdr,sizeof(hdr),"SIZE %lld\n\n",size);
+    char etag[96]; etag_of(&st,etag,sizeof(etag));
+    char hdr[160]; int hn = snprintf(hdr,sizeof(hdr),"ETAG %s\nSIZE %lld\n\n",etag,size);
     if(send_all(cfd,hdr,(size_t)hn)<0){ close(fd); return -1; }
 
+#ifdef HAVE_URING
+    if(want_body && size>0 && g_ur.fd>=0){
+        int r = ur_send_file(cfd,fd,size);
+        if(r!=-2){ close(fd); return r; }
+    }
+#endif
     if(want_body && size>0){
         char buf[8192]; long long left=size;
         while(left>0){
@@ -115,6 +411,452 @@ static int do_send_file(int cfd, const char *rootdir, const char *name, bool wan
     return 0;
 }
 
+// ---- WATCH: inotify-driven change feed ----
+
+struct watcher {
+    int fd;
+    size_t len;        // queued, unsent bytes in out[]
+    size_t head_sent;  // bytes of the line at out[0] already on the wire
+    bool resync;       // RESYNC queued; drop events until it is out
+    char out[WATCH_BACKLOG];
+};
+struct pending_ev { char name[256]; bool created; };
+
+static struct watcher g_watchers[MAX_WATCHERS];
+static int g_nwatchers = 0;
+static int g_inotify_fd = -1;
+static struct pending_ev g_pending[MAX_PENDING];
+static int g_npending = 0;
+static bool g_pending_resync = false;
+static long long g_pending_deadline = 0;   // ms; 0 = nothing pending
+
+static long long now_ms(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (long long)ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+static void watcher_drop(int i){
+    close(g_watchers[i].fd);
+    g_watchers[i] = g_watchers[--g_nwatchers];   // struct copy keeps queued bytes
+#ifdef HAVE_INOTIFY
+    if(g_nwatchers==0 && g_inotify_fd>=0){ close(g_inotify_fd); g_inotify_fd=-1; g_npending=0; g_pending_resync=false; g_pending_deadline=0; }
+#endif
+}
+
+// Push as much of the backlog as the socket takes without blocking.
+static int watcher_flush(struct watcher *w){
+    while(w->len){
+        ssize_t n = send(w->fd,w->out,w->len,0);   // fd is O_NONBLOCK
+        if(n<0){ if(errno==EINTR) continue; if(errno==EAGAIN||errno==EWOULDBLOCK) return 0; return -1; }
+        const char *nl = NULL;
+        for(const char *q=w->out+n; q>w->out; q--) if(q[-1]=='\n'){ nl = q; break; }
+        w->head_sent = nl ? (size_t)(w->out+n-nl) : w->head_sent+(size_t)n;
+        memmove(w->out,w->out+n,w->len-(size_t)n); w->len -= (size_t)n;
+    }
+    w->resync = false;
+    return 0;
+}
+
+// Queue one event line; a subscriber that falls WATCH_BACKLOG behind loses
+// its backlog and gets a single RESYNC instead. The rest of a partly sent
+// line is kept so RESYNC still starts on a line of its own.
+static void watcher_queue(struct watcher *w, const char *line, size_t n){
+    if(w->resync) return;   // already told to re-LIST
+    if(w->len + n > sizeof(w->out)){
+        size_t keep = 0;
+        if(w->head_sent) keep = (size_t)((char*)memchr(w->out,'\n',w->len) - w->out) + 1;
+        memcpy(w->out+keep,"RESYNC\n",7); w->len = keep+7; w->resync = true;
+        return;
+    }
+    memcpy(w->out+w->len,line,n); w->len += n;
+}
+
+static void watch_broadcast(const char *line, size_t n){
+    for(int i=0;i<g_nwatchers;i++) watcher_queue(&g_watchers[i],line,n);
+}
+
+#ifdef HAVE_INOTIFY
+static void pending_add(const char *name, bool created){
+    if(g_pending_deadline==0) g_pending_deadline = now_ms() + WATCH_COALESCE_MS;
+    if(g_pending_resync) return;
+    if(!valid_name(name)) return;
+    for(int i=0;i<g_npending;i++){
+        if(strcmp(g_pending[i].name,name)==0){ g_pending[i].created |= created; return; }
+    }
+    if(g_npending==MAX_PENDING || strlen(name)>=sizeof(g_pending[0].name)){ g_pending_resync=true; return; }
+    strcpy(g_pending[g_npending].name,name);
+    g_pending[g_npending++].created = created;
+}
+
+static void watch_read_events(void){
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for(;;){
+        ssize_t n = read(g_inotify_fd,buf,sizeof(buf));
+        if(n<0){ if(errno==EINTR) continue; return; }   // EAGAIN: drained
+        if(n==0) return;
+        for(char *p=buf; p<buf+n; ){
+            struct inotify_event *ev = (struct inotify_event*)p;
+            if(ev->mask & IN_Q_OVERFLOW){ if(g_pending_deadline==0) g_pending_deadline=now_ms()+WATCH_COALESCE_MS; g_pending_resync=true; }
+            else if(ev->len>0 && !(ev->mask & IN_ISDIR)) pending_add(ev->name, (ev->mask & (IN_CREATE|IN_MOVED_TO))!=0);
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+}
+
+static int watch_start(const char *rootdir){
+    if(g_inotify_fd>=0) return 0;
+    g_inotify_fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if(g_inotify_fd<0) return -1;
+    uint32_t mask = IN_CREATE|IN_DELETE|IN_MODIFY|IN_CLOSE_WRITE|IN_ATTRIB|IN_MOVED_FROM|IN_MOVED_TO;
+    if(inotify_add_watch(g_inotify_fd,rootdir,mask)<0){ close(g_inotify_fd); g_inotify_fd=-1; return -1; }
+    return 0;
+}
+#endif
+
+// End of a coalescing window: one line per touched name, state taken from
+// disk now rather than replayed from the raw event sequence.
+static void watch_emit_pending(const char *rootdir){
+    if(g_pending_resync) watch_broadcast("RESYNC\n",7);
+    else for(int i=0;i<g_npending;i++){
+        char path[1024], line[1024]; int n;
+        int pn = snprintf(path,sizeof(path),"%s/%s",rootdir,g_pending[i].name);
+        if(pn<0 || (size_t)pn>=sizeof(path)) continue;
+        struct stat st;
+        if(stat(path,&st)==0){
+            if(!S_ISREG(st.st_mode)) continue;
+            n = snprintf(line,sizeof(line),"%s %s\t%lld\n",g_pending[i].created?"ADD":"MOD",
+                         g_pending[i].name,(long long)st.st_size);
+        } else {
+            n = snprintf(line,sizeof(line),"DEL %s\n",g_pending[i].name);
+        }
+        if(n>0 && (size_t)n<sizeof(line)) watch_broadcast(line,(size_t)n);
+    }
+    g_npending=0; g_pending_resync=false; g_pending_deadline=0;
+}
+
+static int do_watch(int cfd, const char *rootdir){
+#ifdef HAVE_INOTIFY
+    if(g_nwatchers==MAX_WATCHERS) return send_all(cfd,"ERR too many watchers\n",22);
+    if(watch_start(rootdir)<0){ char e[256]; int n=snprintf(e,sizeof(e),"ERR watch (%s)\n", strerror(errno));
+            return send_all(cfd,e,(size_t)n); }
+    if(send_all(cfd,"WATCHING\n\n",10)<0) return -1;
+    int fl = fcntl(cfd,F_GETFL,0); fcntl(cfd,F_SETFL,fl|O_NONBLOCK);
+    g_watchers[g_nwatchers].fd = cfd; g_watchers[g_nwatchers].len = 0;
+    g_watchers[g_nwatchers].head_sent = 0; g_watchers[g_nwatchers].resync = false; g_nwatchers++;
+    return KEEP_OPEN;
+#else
+    (void)rootdir;
+    return send_all(cfd,"ERR watch unsupported\n",22);
+#endif
+}
+
+// ---- GREP: matching lines of a mapped file ----
+
+// Finds needle[0..k) in [p,end); returns its start or NULL.
+typedef const char *(*find_fn)(const char *p, const char *end, const char *needle, size_t k);
+// Counts '\n' in [p,end).
+typedef size_t (*count_fn)(const char *p, const char *end);
+
+static const char *find_scalar(const char *p, const char *end, const char *needle, size_t k){
+    while((size_t)(end-p) >= k){
+        const char *c = memchr(p,needle[0],(size_t)(end-p)-k+1);
+        if(!c) return NULL;
+        if(memcmp(c+1,needle+1,k-1)==0) return c;
+        p = c+1;
+    }
+    return NULL;
+}
+
+static size_t count_nl_scalar(const char *p, const char *end){
+    size_t n=0;
+    while((p = memchr(p,'\n',(size_t)(end-p)))){ n++; p++; }
+    return n;
+}
+
+#ifdef HAVE_X86_SIMD
+// First+last byte filter (W. Mula's "generic SIMD" strstr): a candidate needs
+// needle[0] at i and needle[k-1] at i+k-1; only those get a memcmp. Rare first
+// bytes keep the inner loop a pure streaming compare.
+static const char *find_sse2(const char *p, const char *end, const char *needle, size_t k){
+    const __m128i first = _mm_set1_epi8(needle[0]), last = _mm_set1_epi8(needle[k-1]);
+    while((size_t)(end-p) >= k+31){   // two blocks per branch
+        __m128i e0 = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p),first),
+                                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p+k-1)),last));
+        __m128i e1 = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p+16)),first),
+                                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p+16+k-1)),last));
+        unsigned m = (unsigned)_mm_movemask_epi8(e0) | (unsigned)_mm_movemask_epi8(e1)<<16;
+        while(m){
+            int i = __builtin_ctz(m);
+            if(memcmp(p+i+1,needle+1,k-1)==0) return p+i;
+            m &= m-1;
+        }
+        p += 32;
+    }
+    return find_scalar(p,end,needle,k);
+}
+
+static size_t count_nl_sse2(const char *p, const char *end){
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t n=0;
+    for(; end-p >= 16; p += 16)
+        n += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p),nl)));
+    return n + count_nl_scalar(p,end);
+}
+
+__attribute__((target("avx2")))
+static const char *find_avx2(const char *p, const char *end, const char *needle, size_t k){
+    const __m256i first = _mm256_set1_epi8(needle[0]), last = _mm256_set1_epi8(needle[k-1]);
+    while((size_t)(end-p) >= k+63){   // two blocks per branch
+        __m256i f0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p),first);
+        __m256i f1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p+32)),first);
+        __m256i f = _mm256_or_si256(f0,f1);
+        if(_mm256_testz_si256(f,f)){ p += 64; continue; }   // rare first byte: memchr pace
+        __m256i e0 = _mm256_and_si256(f0,_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p+k-1)),last));
+        __m256i e1 = _mm256_and_si256(f1,_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p+32+k-1)),last));
+        uint64_t m = (uint32_t)_mm256_movemask_epi8(e0) | (uint64_t)(uint32_t)_mm256_movemask_epi8(e1)<<32;
+        while(m){
+            int i = __builtin_ctzll(m);
+            if(memcmp(p+i+1,needle+1,k-1)==0) return p+i;
+            m &= m-1;
+        }
+        p += 64;
+    }
+    return find_sse2(p,end,needle,k);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t count_nl_avx2(const char *p, const char *end){
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t n=0;
+    for(; end-p >= 32; p += 32)
+        n += (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p),nl)));
+    return n + count_nl_sse2(p,end);
+}
+#endif
+
+struct grep_impl { const char *name; find_fn find; count_fn count_nl; };
+
+static const struct grep_impl g_grep_impls[] = {
+#ifdef HAVE_X86_SIMD
+    { "avx2",   find_avx2,   count_nl_avx2 },
+    { "sse2",   find_sse2,   count_nl_sse2 },
+#endif
+    { "scalar", find_scalar, count_nl_scalar },
+};
+
+static bool grep_impl_usable(const struct grep_impl *g){
+#ifdef HAVE_X86_SIMD
+    if(g->find==find_avx2) return __builtin_cpu_supports("avx2");
+#endif
+    (void)g;
+    return true;
+}
+
+// Best scanner this CPU runs; picked once.
+static const struct grep_impl *grep_impl(void){
+    static const struct grep_impl *best;
+    if(!best){
+        for(size_t i=0;i<sizeof(g_grep_impls)/sizeof(g_grep_impls[0]) && !best;i++)
+            if(grep_impl_usable(&g_grep_impls[i])) best = &g_grep_impls[i];
+    }
+    return best;
+}
+
+struct grep_req { const char *pat; size_t k; bool bol, eol, numbers; long long max; };
+// Called once per matching line (without its '\n'); nonzero stops the scan.
+typedef int (*grep_emit)(void *ctx, const char *line, size_t len, long long lineno);
+
+// Feeds the matching lines of map[0..size) to emit(), at most rq->max of them
+// (0 = no limit). Returns how many were emitted, or -1 if emit() stopped it.
+// Every line is looked at once: an anchored pattern is checked against the
+// whole line the first time find() lands in it.
+static long long grep_scan(const struct grep_impl *g, const char *map, size_t size,
+                           const struct grep_req *rq, grep_emit emit, void *ctx){
+    long long n = 0;
+    const char *p = map, *end = map + size, *counted = map;
+    long long lineno = 1;
+    while(p < end && (rq->max<=0 || n<rq->max)){
+        const char *h = g->find(p,end,rq->pat,rq->k);
+        if(!h) break;
+        const char *ls = h;
+        while(ls>map && ls[-1]!='\n') ls--;
+        const char *le = memchr(h+rq->k,'\n',(size_t)(end-(h+rq->k)));
+        if(!le) le = end;
+        size_t ll = (size_t)(le-ls);
+        bool ok = (!(rq->bol && rq->eol) || ll==rq->k) &&   // both anchors: the whole line
+                  (!rq->bol || (ll>=rq->k && memcmp(ls,rq->pat,rq->k)==0)) &&
+                  (!rq->eol || (ll>=rq->k && memcmp(le-rq->k,rq->pat,rq->k)==0));
+        if(!ok){ p = le+1; continue; }
+        if(rq->numbers){ lineno += (long long)g->count_nl(counted,ls); counted = ls; }
+        if(emit(ctx,ls,ll,lineno)) return -1;
+        n++;
+        p = le+1;
+    }
+    return n;
+}
+
+// GREP replies in two passes over the mapping: the first only adds up the
+// body for the SIZE header, the second streams it. Memory stays at one
+// GREP_OUTBUF however many lines match.
+struct grep_out {
+    int cfd; bool numbers;
+    long long total, sent;     // body bytes: announced / streamed so far
+    size_t used; char buf[GREP_OUTBUF];
+};
+
+static int grep_count(void *ctx, const char *line, size_t len, long long lineno){
+    struct grep_out *o = ctx; (void)line;
+    o->total += (long long)len + 1;
+    if(o->numbers){   // "<lineno>:"
+        int d = 2;
+        for(long long v=lineno; v>=10; v/=10) d++;
+        o->total += d;
+    }
+    return 0;
+}
+
+static int grep_flush(struct grep_out *o){
+    int rc = o->used ? send_all(o->cfd,o->buf,o->used) : 0;
+    o->used = 0;
+    return rc;
+}
+
+// Small lines are batched into buf; long ones go straight from the map.
+static int grep_send(void *ctx, const char *line, size_t len, long long lineno){
+    struct grep_out *o = ctx;
+    char num[24]; size_t nn = 0;
+    if(o->numbers) nn = (size_t)snprintf(num,sizeof(num),"%lld:",lineno);
+    if(o->sent + (long long)(nn+len+1) > o->total) return -1;   // file changed since the counting pass
+    o->sent += (long long)(nn+len+1);
+    if(o->used + nn + len + 1 > sizeof(o->buf) && grep_flush(o)<0) return -1;
+    memcpy(o->buf+o->used,num,nn); o->used += nn;
+    if(len + 1 > sizeof(o->buf)-o->used){
+        if(grep_flush(o)<0 || send_all(o->cfd,line,len)<0) return -1;
+    } else {
+        memcpy(o->buf+o->used,line,len); o->used += len;
+    }
+    o->buf[o->used++] = '\n';
+    return 0;
+}
+
+// A file truncated under the mapping (copytruncate log rotation) raises
+// SIGBUS on the vanished pages; do_grep() jumps back out instead of dying.
+static sigjmp_buf g_grep_jmp;
+static volatile sig_atomic_t g_grep_mapped = 0;
+static void on_sigbus(int signum){
+    if(g_grep_mapped) siglongjmp(g_grep_jmp,1);
+    signal(signum,SIG_DFL); raise(signum);   // not ours: crash as usual
+}
+
+// GREP [-n] [-m <max>] <name>\t<pattern>
+static int do_grep(int cfd, const char *rootdir, char *args){
+    struct grep_req rq = { 0 };
+    for(;;){
+        if(strncmp(args,"-n ",3)==0){ rq.numbers = true; args += 3; }
+        else if(strncmp(args,"-m ",3)==0){ rq.max = strtoll(args+3,&args,10); while(*args==' ') args++; }
+        else break;
+    }
+    char *tab = strchr(args,'\t');
+    if(!tab) return send_all(cfd,"ERR usage: GREP [-n] [-m <max>] <name>\\t<pattern>\n",50);
+    *tab = '\0';
+    const char *name = args;
+    char *pat = tab+1;
+    size_t k = strlen(pat);
+    if(k>0 && pat[0]=='^'){ rq.bol = true; pat++; k--; }
+    if(k>0 && pat[k-1]=='$'){ rq.eol = true; pat[--k] = '\0'; }
+    if(k==0) return send_all(cfd,"ERR empty pattern\n",18);
+    rq.pat = pat; rq.k = k;
+    if(!valid_name(name)) return send_all(cfd,"ERR bad name\n",13);
+
+    char path[1024];
+    int pn = snprintf(path,sizeof(path),"%s/%s",rootdir,name);
+    if(pn<0 || (size_t)pn>=sizeof(path)) return send_all(cfd,"ERR name too long\n",18);
+    int fd = open(path,O_RDONLY);
+    if(fd<0){ char e[256]; int n=snprintf(e,sizeof(e),"ERR open (%s)\n", strerror(errno)); return send_all(cfd,e,(size_t)n); }
+    struct stat st;
+    if(fstat(fd,&st)<0 || !S_ISREG(st.st_mode)){ close(fd); return send_all(cfd,"ERR not file\n",13); }
+
+    size_t size = (size_t)st.st_size;
+    const char *map = NULL;
+    if(size>0){
+        map = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+        if(map==MAP_FAILED){ close(fd); return send_all(cfd,"ERR mmap\n",9); }
+        posix_madvise((void*)map,size,POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    static struct grep_out o;   // static: 64 KiB buffer off the stack
+    memset(&o,0,offsetof(struct grep_out,buf));
+    o.cfd = cfd; o.numbers = rq.numbers;
+    volatile bool streaming = false;
+    if(size>0 && sigsetjmp(g_grep_jmp,1)){
+        g_grep_mapped = 0;
+        munmap((void*)map,size);
+        if(streaming) return -1;   // header already out: cut the body short
+        return send_all(cfd,"ERR file shrank during scan\n",28);
+    }
+    g_grep_mapped = size>0;
+    const struct grep_impl *g = grep_impl();
+    long long n = size ? grep_scan(g,map,size,&rq,grep_count,&o) : 0;
+
+    char hdr[96]; int hn = snprintf(hdr,sizeof(hdr),"MATCHES %lld\nSIZE %lld\n\n",n,o.total);
+    int rc = send_all(cfd,hdr,(size_t)hn);
+    streaming = true;
+    if(rc==0 && n>0){
+        struct grep_req again = rq;
+        again.max = n;   // the same lines, no more
+        // A file rewritten in place between the passes can't match the header: cut it short.
+        if(grep_scan(g,map,size,&again,grep_send,&o)<0 || grep_flush(&o)<0 || o.sent!=o.total) rc = -1;
+    }
+    g_grep_mapped = 0;
+    if(map) munmap((void*)map,size);
+    return rc;
+}
+
+// --bench-grep: every scanner vs. memchr() for an absent byte, which libc
+// runs at memory bandwidth. Best of 5 passes over a pre-faulted mapping.
+static int bench_grep(const char *file, const char *pattern){
+    int fd = open(file,O_RDONLY);
+    struct stat st;
+    if(fd<0 || fstat(fd,&st)<0 || st.st_size==0){ perror(file); return 1; }
+    size_t size = (size_t)st.st_size;
+    char *map = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(map==MAP_FAILED){ perror("mmap"); return 1; }
+    volatile char sink = 0;
+    for(size_t i=0;i<size;i+=4096) sink ^= map[i];   // fault everything in first
+
+    char pat[512]; snprintf(pat,sizeof(pat),"%s",pattern);
+    struct grep_req rq = { .pat = pat, .k = strlen(pat), .numbers = true };
+    if(rq.k>0 && pat[0]=='^'){ rq.bol = true; rq.pat++; rq.k--; }
+    if(rq.k>0 && rq.pat[rq.k-1]=='$'){ rq.eol = true; pat[strlen(pat)-1] = '\0'; rq.k--; }
+    if(rq.k==0){ fprintf(stderr,"empty pattern\n"); return 1; }
+
+    printf("%zu bytes, pattern \"%s\"\n",size,pattern);
+    for(int impl=-1; impl<(int)(sizeof(g_grep_impls)/sizeof(g_grep_impls[0])); impl++){
+        if(impl>=0 && !grep_impl_usable(&g_grep_impls[impl])) continue;
+        double best = 1e30; long long n = 0;
+        for(int rep=0;rep<5;rep++){
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC,&t0);
+            if(impl<0){ n = memchr(map,'\x01',size)!=NULL; }
+            else{
+                static struct grep_out o;
+                o.total = 0; o.numbers = rq.numbers;
+                n = grep_scan(&g_grep_impls[impl],map,size,&rq,grep_count,&o);
+            }
+            clock_gettime(CLOCK_MONOTONIC,&t1);
+            double dt = (double)(t1.tv_sec-t0.tv_sec) + (double)(t1.tv_nsec-t0.tv_nsec)/1e9;
+            if(dt<best) best = dt;
+        }
+        printf("  %-16s %8.2f GB/s  (%lld %s)\n", impl<0 ? "memchr baseline" : g_grep_impls[impl].name,
+               (double)size/best/1e9, n, impl<0 ? "hit" : "matches");
+    }
+    (void)sink;
+    munmap(map,size);
+    return 0;
+}
+
 static int serve_once(int cfd, const char *rootdir){
     char line[512];
     ssize_t rn = recv_line(cfd, line, sizeof(line));
@@ -126,14 +868,21 @@ static int serve_once(int cfd, const char *rootdir){
     if(strcmp(line,"LIST")==0)               return do_list(cfd, rootdir);
     else if(strncmp(line,"GET ",4)==0)       return do_send_file(cfd, rootdir, line+4, true);
     else if(strncmp(line,"HEAD ",5)==0)      return do_send_file(cfd, rootdir, line+5, false);
+    else if(strcmp(line,"WATCH")==0)         return do_watch(cfd, rootdir);
+    else if(strncmp(line,"GREP ",5)==0)      return do_grep(cfd, rootdir, line+5);
     else                                     return send_all(cfd,"ERR unknown command\n",20);
 }
 
 int main(int argc, char **argv){
-    if(argc!=3){ fprintf(stderr,"Usage: %s <port> <root-directory>\n",argv[0]); return 1; }
-    const char *port=argv[1], *root=argv[2];
+    if(argc==4 && strcmp(argv[1],"--bench-grep")==0) return bench_grep(argv[2],argv[3]);
+    bool want_uring=false, bad=false; int opt;
+    while((opt=getopt(argc,argv,"u"))!=-1){ if(opt=='u') want_uring=true; else bad=true; }
+    if(bad || argc-optind!=2){ fprintf(stderr,"Usage: %s [-u] <port> <root-directory>\n       %s --bench-grep <file> <pattern>\n",argv[0],argv[0]); return 1; }
+    const char *port=argv[optind], *root=argv[optind+1];
 
     signal(SIGINT,on_sigint); signal(SIGTERM,on_sigint);
+    signal(SIGPIPE,SIG_IGN);   // a vanished subscriber must not take the server down
+    signal(SIGBUS,on_sigbus);  // GREP on a file truncated mid-scan
 
     struct addrinfo hints, *res=NULL;
     memset(&hints,0,sizeof(hints));
@@ -153,15 +902,72 @@ int main(int argc, char **argv){
     freeaddrinfo(res);
     if(listen(sfd,16)<0){ perror("listen"); close(sfd); return 1; }
 
+    if(want_uring){
+#ifdef HAVE_URING
+        if(ur_init(sfd)) fprintf(stderr,"io_uring backend: %d reads x %d KiB in flight per transfer\n",URING_QD,URING_BUF/1024);
+        else fprintf(stderr,"io_uring unavailable (%s), using read()/send()\n",strerror(errno));
+#else
+        fprintf(stderr,"io_uring not built in, using read()/send()\n");
+#endif
+    }
     fprintf(stderr,"Serving files from %s on port %s\n",root,port);
 
     while(!g_stop){
-        struct sockaddr_storage ss; socklen_t slen=sizeof(ss);
-        int cfd = accept(sfd,(struct sockaddr*)&ss,&slen);
-        if(cfd<0){ if(errno==EINTR && g_stop) break; if(errno==EINTR) continue; perror("accept"); break; }
-        serve_once(cfd, root);
-        close(cfd);
+        // [0] listener, [1] inotify (or -1), [2..] subscribers
+        struct pollfd pfd[2+MAX_WATCHERS];
+        pfd[0].fd = sfd;          pfd[0].events = POLLIN;
+#ifdef HAVE_URING
+        if(g_ur.fd>=0) ur_arm_accept();   // may abandon the ring
+        if(g_ur.fd>=0) pfd[0].fd = g_ur.fd;   // ring fd polls readable on completions
+#endif
+        pfd[1].fd = g_inotify_fd; pfd[1].events = POLLIN;
+        for(int i=0;i<g_nwatchers;i++){
+            pfd[2+i].fd = g_watchers[i].fd;
+            pfd[2+i].events = POLLIN | (g_watchers[i].len ? POLLOUT : 0);
+        }
+        int nw = g_nwatchers;
+        int timeout = -1;
+        if(g_pending_deadline){ long long d = g_pending_deadline - now_ms(); timeout = d>0 ? (int)d : 0; }
+#ifdef HAVE_URING
+        if(g_ur.accepted>=0) timeout = 0;
+#endif
+
+        int pr = poll(pfd,(nfds_t)(2+nw),timeout);
+        if(pr<0){ if(errno==EINTR) continue; perror("poll"); break; }
+
+#ifdef HAVE_INOTIFY
+        if(g_inotify_fd>=0 && (pfd[1].revents & POLLIN)) watch_read_events();
+#endif
+        if(g_pending_deadline && now_ms()>=g_pending_deadline) watch_emit_pending(root);
+
+        // Subscribers: any input or hangup ends the subscription; otherwise drain backlog.
+        for(int i=nw-1;i>=0;i--){
+            short re = pfd[2+i].revents;
+            if(re & (POLLIN|POLLERR|POLLHUP|POLLNVAL)){ watcher_drop(i); continue; }
+            if(watcher_flush(&g_watchers[i])<0) watcher_drop(i);
+        }
+
+#ifdef HAVE_URING
+        if(g_ur.fd>=0){
+            uint64_t ud; int res;
+            while(ur_cqe(&ud,&res)) if((ud>>32)==UD_ACCEPT) ur_on_accept(res);
+        }
+        if(g_ur.accepted>=0){   // also served if the ring was abandoned after parking it
+            int cfd = g_ur.accepted; g_ur.accepted = -1;
+            if(g_ur.fd>=0) ur_arm_accept();   // next accept is in flight while this one is served
+            if(serve_once(cfd, root)!=KEEP_OPEN) close(cfd);
+            continue;
+        }
+        if(g_ur.fd>=0 || pfd[0].fd!=sfd) continue;   // ring events only, or ring just abandoned
+#endif
+        if(pfd[0].revents & POLLIN){
+            struct sockaddr_storage ss; socklen_t slen=sizeof(ss);
+            int cfd = accept(sfd,(struct sockaddr*)&ss,&slen);
+            if(cfd<0){ if(errno==EINTR) continue; perror("accept"); break; }
+            if(serve_once(cfd, root)!=KEEP_OPEN) close(cfd);
+        }
     }
+    while(g_nwatchers>0) watcher_drop(g_nwatchers-1);
     close(sfd);
     return 0;
 }